@@ -1,5 +1,27 @@
 #if !defined TERRARIA_H
 
+// Helper macros for sizes and arrays
+#define Kilobytes(Value) ((Value) * 1024LL)
+#define Megabytes(Value) (Kilobytes(Value) * 1024LL)
+#define Gigabytes(Value) (Megabytes(Value) * 1024LL)
+#define Terabytes(Value) (Gigabytes(Value) * 1024LL)
+#define ArrayCount(Array) (sizeof(Array) / sizeof((Array)[0]))
+
+// Crash on purpose so the debugger stops right where the expression failed
+#define Assert(Expression) if (!(Expression)) { *(volatile int*)0 = 0; }
+
+// Index of the lowest set bit, Value must not be 0
+inline uint32 FindLowestSetBit(uint64 Value)
+{
+#if defined(_MSC_VER)
+    unsigned long Index;
+    _BitScanForward64(&Index, Value);
+    return (uint32)Index;
+#else
+    return (uint32)__builtin_ctzll(Value);
+#endif
+}
+
 // Structure that contains data about the buffer
 struct game_Offscreen_Buffer
 {
@@ -18,7 +40,209 @@ struct game_Sound_Output_Buffer
     int16* Samples;
 };
 
-internal void GameUpdateAndRender(game_Offscreen_Buffer* Buffer, int xOffset, int yOffset, game_Sound_Output_Buffer* SoundBuffer);
+// The platform layer owns the worker threads, the game only hands it jobs.
+// AddEntry pushes a job, CompleteAllWork blocks (and helps out) until every pushed job is done
+struct platform_Work_Queue;
+
+#define PLATFORM_WORK_QUEUE_CALLBACK(name) void name(platform_Work_Queue* Queue, void* Data)
+typedef PLATFORM_WORK_QUEUE_CALLBACK(platform_Work_Queue_Callback);
+
+typedef void platform_Add_Entry(platform_Work_Queue* Queue, platform_Work_Queue_Callback* Callback, void* Data);
+typedef void platform_Complete_All_Work(platform_Work_Queue* Queue);
+
+// Set to 1 to keep the particle pools full and print the cycle counters every frame
+#if !defined TERRARIA_BENCHMARK
+#define TERRARIA_BENCHMARK 0
+#endif
+
+// The game runs at a fixed rate so every tick advances the simulation by the same amount
+#define GAME_UPDATE_HZ 60
+
+// Cycle counters filled by the game and reported (then cleared) by the platform layer every frame.
+// HitCount is the number of items processed, so CycleCount / HitCount is the cost per item
+enum
+{
+    DebugCycleCounter_GameUpdateAndRender,
+    DebugCycleCounter_ApplyTileEdits,
+    DebugCycleCounter_UpdatePathGraph,
+    DebugCycleCounter_ProcessPathRequests,
+    DebugCycleCounter_UpdateParticles,
+    DebugCycleCounter_RenderParticles,
+    DebugCycleCounter_EncodeSnapshots,
+    DebugCycleCounter_RenderText,
+
+    DebugCycleCounter_Count,
+};
+
+struct debug_Cycle_Counter
+{
+    uint64 CycleCount;
+    uint32 HitCount;
+};
+
+// Replication traffic per client, filled and cleared like the cycle counters and reported next to EncodeSnapshots
+#define DEBUG_NET_CLIENT_COUNT 4
+
+struct debug_Net_Counter
+{
+    uint32 TickCount;
+    uint32 BytesSent;
+    uint32 ChunksSent;
+};
+
+// Memory handed to the game by the platform layer, the game never allocates on its own.
+// Permanent storage holds the game state, transient storage holds anything that can be rebuilt
+struct game_Memory
+{
+    bool32 IsInitialized;
+
+    uint64 PermanentStorageSize;
+    void* PermanentStorage;
+
+    uint64 TransientStorageSize;
+    void* TransientStorage;
+
+    platform_Work_Queue* WorkQueue;
+    platform_Add_Entry* PlatformAddEntry;
+    platform_Complete_All_Work* PlatformCompleteAllWork;
+
+    debug_Cycle_Counter Counters[DebugCycleCounter_Count];
+    debug_Net_Counter NetCounters[DEBUG_NET_CLIENT_COUNT];
+
+    // How long the previous frame took as the platform layer measured it, shown by the debug overlay
+    int32 LastMillisecondsPerFrame;
+    int32 LastFramesPerSecond;
+    int32 LastMegaCyclesPerFrame;
+};
+
+#define BEGIN_TIMED_BLOCK(ID) uint64 StartCycleCount##ID = __rdtsc();
+#define END_TIMED_BLOCK_COUNTED(ID, Count) DebugGlobalMemory->Counters[DebugCycleCounter_##ID].CycleCount += __rdtsc() - StartCycleCount##ID; DebugGlobalMemory->Counters[DebugCycleCounter_##ID].HitCount += (Count);
+#define END_TIMED_BLOCK(ID) END_TIMED_BLOCK_COUNTED(ID, 1)
+
+internal void GameUpdateAndRender(game_Memory* Memory, game_Offscreen_Buffer* Buffer, int xOffset, int yOffset, game_Sound_Output_Buffer* SoundBuffer);
+
+// Linear allocator carved out of the game memory, nothing is ever freed individually
+struct memory_Arena
+{
+    uint8* Base;
+    size_t Size;
+    size_t Used;
+};
+
+internal void InitializeArena(memory_Arena* Arena, size_t Size, void* Base)
+{
+    Arena->Base = (uint8*)Base;
+    Arena->Size = Size;
+    Arena->Used = 0;
+}
+
+#define PushStruct(Arena, type) (type*)PushSize_(Arena, sizeof(type))
+#define PushArray(Arena, Count, type) (type*)PushSize_(Arena, (Count) * sizeof(type))
+
+internal void* PushSize_(memory_Arena* Arena, size_t Size)
+{
+    // Keep every allocation 16 byte aligned so the SIMD code can use aligned loads
+    size_t ResultPointer = (size_t)Arena->Base + Arena->Used;
+    size_t AlignmentOffset = (16 - (ResultPointer & 15)) & 15;
+    Assert((Arena->Used + AlignmentOffset + Size) <= Arena->Size);
+
+    void* Result = (void*)(ResultPointer + AlignmentOffset);
+    Arena->Used += AlignmentOffset + Size;
+
+    return Result;
+}
+
+// Small xorshift generator so the game stays deterministic across runs
+struct random_Series
+{
+    uint32 State;
+};
+
+internal uint32 RandomNext(random_Series* Series)
+{
+    uint32 Result = Series->State;
+    Result ^= Result << 13;
+    Result ^= Result >> 17;
+    Result ^= Result << 5;
+    Series->State = Result;
+
+    return Result;
+}
+
+internal int32 RandomBetween(random_Series* Series, int32 Min, int32 Max)
+{
+    return Min + (int32)(RandomNext(Series) % (uint32)(Max - Min + 1));
+}
+
+internal real32 RandomUnilateral(random_Series* Series)
+{
+    return (real32)(RandomNext(Series) >> 8) * (1.0f / 16777216.0f);
+}
+
+#include "Terraria_World.h"
+#include "Terraria_Pathfinding.h"
+#include "Terraria_Particles.h"
+#include "Terraria_Text.h"
+
+#define NPC_COUNT 32
+
+struct game_Npc
+{
+    int32 TileX;
+    int32 TileY;
+
+    path_Result Path;
+    int32 PathStep;
+    bool32 PathPending;
+
+    // Ticks left before the NPC moves onto the next tile of its path
+    int32 MoveCooldown;
+    uint32 Color;
+};
+
+#include "Terraria_Network.h"
+
+// How many in-process clients the game replicates to, each one follows an NPC as a stand-in for its player
+#define NET_LOOPBACK_CLIENT_COUNT 2
+
+// Lives at the very start of the permanent storage
+struct game_State
+{
+    memory_Arena WorldArena;
+    uint32 TickIndex;
+
+    random_Series Entropy;
+    game_World* World;
+    path_Graph* PathGraph;
+
+    // Every tile change goes through the queue, the dirty mask is what it changed this tick
+    tile_Edit_Queue* TileEdits;
+    world_Dirty_Mask DirtyChunks;
+    world_Border_Masks DirtyBorders;
+    world_Render_Cache RenderCache;
+
+    int32 NpcCount;
+    game_Npc Npcs[NPC_COUNT];
+
+    // The game acts as the server, replicating to clients that live in the same process for now
+    net_Loopback* Loopback;
+    net_Transport LoopbackTransport;
+    net_Server* Server;
+    net_Client* Clients[NET_LOOPBACK_CLIENT_COUNT];
+};
+
+// Lives at the very start of the transient storage, everything in here can be thrown away and rebuilt
+struct transient_State
+{
+    bool32 IsInitialized;
+    memory_Arena TransientArena;
+
+    path_Scratch* PathScratch[PATH_WORKER_COUNT];
+    particle_System Particles;
+
+    text_State Text;
+    floating_Number_List FloatingNumbers;
+};
 
 #define TERRARIA_H
-#endif
\ No newline at end of file
+#endif
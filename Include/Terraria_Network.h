@@ -0,0 +1,128 @@
+#if !defined TERRARIA_NETWORK_H
+
+// Server -> client replication of the tile world and the entities.
+// Every tick the server writes one snapshot per client, containing only what that client has not acknowledged yet:
+// - Entities are delta encoded against the last snapshot the client acknowledged, with small moves packed into a few bits
+// - Chunks around the client's player are sent (run length encoded) when they changed after the client last acknowledged them
+// The transport is a pair of function pointers so the same code runs over the in-process loopback and, later, real sockets
+
+#define NET_MAX_CLIENTS 4
+#define NET_MAX_ENTITIES NPC_COUNT
+#define NET_MAX_PACKET_SIZE 8192
+#define NET_SNAPSHOT_HISTORY 32
+#define NET_MAX_CHUNKS_PER_SNAPSHOT 16
+#define NET_INTEREST_RADIUS 2
+#define NET_RESEND_TICKS 8
+
+// Worst case for one run length encoded chunk: every tile its own run, plus the chunk index and run count
+#define NET_MAX_CHUNK_BYTES ((WORLD_CHUNK_TILE_COUNT * 7 + 32) / 8 + 4)
+
+struct net_Transport;
+
+#define NET_SEND(name) bool32 name(net_Transport* Transport, int32 Channel, void* Data, int32 Size)
+typedef NET_SEND(net_Send);
+
+// Returns the size of the received packet, 0 if nothing is waiting
+#define NET_RECEIVE(name) int32 name(net_Transport* Transport, int32 Channel, void* Buffer, int32 BufferSize)
+typedef NET_RECEIVE(net_Receive);
+
+struct net_Transport
+{
+    net_Send* Send;
+    net_Receive* Receive;
+    void* Data;
+};
+
+// Every client has one channel from the server and one back to it
+inline int32 GetChannelToClient(int32 ClientIndex) { return ClientIndex * 2; }
+inline int32 GetChannelToServer(int32 ClientIndex) { return ClientIndex * 2 + 1; }
+
+// In-process stand-in for a socket, packets are copied into a small ring per channel and dropped when it is full.
+// DropEvery > 0 throws away one packet in DropEvery (on average) to exercise the acknowledgement path
+#define NET_LOOPBACK_QUEUE_SIZE 8
+
+struct net_Loopback_Channel
+{
+    int32 ReadIndex;
+    int32 WriteIndex;
+    int32 Sizes[NET_LOOPBACK_QUEUE_SIZE];
+    uint8 Packets[NET_LOOPBACK_QUEUE_SIZE][NET_MAX_PACKET_SIZE];
+};
+
+struct net_Loopback
+{
+    int32 DropEvery;
+    int32 SentCount;
+    net_Loopback_Channel Channels[NET_MAX_CLIENTS * 2];
+};
+
+struct net_Entity_State
+{
+    bool32 Present;
+    int32 TileX;
+    int32 TileY;
+    uint32 Color;
+};
+
+// What the server sent to one client in one snapshot, kept until it is acknowledged or falls out of the history
+struct net_Sent_Snapshot
+{
+    uint32 Tick;
+    net_Entity_State Entities[NET_MAX_ENTITIES];
+
+    int32 ChunkCount;
+    uint16 Chunks[NET_MAX_CHUNKS_PER_SNAPSHOT];
+};
+
+struct net_Server_Client
+{
+    bool32 Connected;
+    int32 PlayerTileX;
+    int32 PlayerTileY;
+
+    uint32 LastAckedTick;
+    net_Sent_Snapshot History[NET_SNAPSHOT_HISTORY];
+
+    // Per chunk: the change the client is known to have, and when it was last sent to it
+    uint32 ChunkAckedTick[WORLD_CHUNK_COUNT];
+    uint32 ChunkSentTick[WORLD_CHUNK_COUNT];
+
+    // Stats of the last tick
+    int32 BytesSent;
+    int32 ChunksSent;
+};
+
+struct net_Server
+{
+    net_Transport* Transport;
+
+    // Tick at which every chunk last changed, fed from the world dirty mask
+    uint32 ChunkChangedTick[WORLD_CHUNK_COUNT];
+
+    net_Server_Client Clients[NET_MAX_CLIENTS];
+
+    // Stats of the last tick, the encode cost is in the EncodeSnapshots cycle counter
+    int32 BytesSent;
+};
+
+struct net_Received_Snapshot
+{
+    uint32 Tick;
+    net_Entity_State Entities[NET_MAX_ENTITIES];
+};
+
+// The receiving end, holds its own copy of everything it was sent
+struct net_Client
+{
+    int32 ClientIndex;
+    net_Transport* Transport;
+
+    uint32 LatestTick;
+    net_Received_Snapshot History[NET_SNAPSHOT_HISTORY];
+
+    game_World World;
+    net_Entity_State Entities[NET_MAX_ENTITIES];
+};
+
+#define TERRARIA_NETWORK_H
+#endif
@@ -0,0 +1,41 @@
+#if !defined TERRARIA_PARTICLES_H
+
+// Particles are purely cosmetic (dust, sparks, mining debris, liquid splashes) and live in the transient storage.
+// Every kind gets its own fixed-capacity pool so all particles of a pool share the same gravity and drag,
+// and every attribute is its own stream so the update can run four particles at a time with SSE
+
+enum particle_Kind
+{
+    ParticleKind_Dust,
+    ParticleKind_Spark,
+    ParticleKind_Debris,
+    ParticleKind_Splash,
+
+    ParticleKind_Count,
+};
+
+struct particle_Pool
+{
+    int32 Count;
+    int32 Capacity;
+
+    // Positions are in world pixels, velocities in pixels per second, life in seconds
+    real32* PositionX;
+    real32* PositionY;
+    real32* VelocityX;
+    real32* VelocityY;
+    real32* Life;
+    uint32* Color;
+
+    real32 Gravity;
+    real32 Drag;
+};
+
+struct particle_System
+{
+    random_Series Entropy;
+    particle_Pool Pools[ParticleKind_Count];
+};
+
+#define TERRARIA_PARTICLES_H
+#endif
@@ -0,0 +1,126 @@
+#if !defined TERRARIA_PATHFINDING_H
+
+// Pathfinding works on two levels:
+// - The top level is a graph of "portals", tiles where a chunk border can be crossed, with the walking
+//   cost between every pair of portals of the same chunk cached per chunk
+// - The bottom level is A* over the tiles of a single chunk, used to turn the portal path back into tiles
+// A chunk graph is only rebuilt when the tiles it depends on change
+
+#define PATH_MAX_NODES_PER_CHUNK 64
+#define PATH_ABSTRACT_NODE_COUNT (WORLD_CHUNK_COUNT * PATH_MAX_NODES_PER_CHUNK)
+#define PATH_NO_NODE 0xFF
+#define PATH_UNREACHABLE 0xFFFF
+
+#define PATH_MAX_STEPS 1024
+#define PATH_MAX_REQUESTS 256
+#define PATH_WORKER_COUNT 8
+
+#define PATH_HEAP_CAPACITY (PATH_ABSTRACT_NODE_COUNT * 4)
+#define PATH_LOCAL_HEAP_CAPACITY (WORLD_CHUNK_TILE_COUNT * 4)
+
+enum path_Side
+{
+    PathSide_West,
+    PathSide_East,
+    PathSide_North,
+    PathSide_South,
+
+    PathSide_Count,
+};
+
+struct path_Chunk_Graph
+{
+    bool32 IsDirty;
+    int32 NodeCount;
+
+    // Tile of each node inside the chunk, packed as (y << WORLD_CHUNK_SHIFT) | x
+    uint16 NodeTile[PATH_MAX_NODES_PER_CHUNK];
+    uint8 NodeSide[PATH_MAX_NODES_PER_CHUNK];
+    uint8 NodeOffset[PATH_MAX_NODES_PER_CHUNK];
+
+    // Which node sits at a given position along a side, used to find the portal on the other side of a border
+    uint8 NodeAt[PathSide_Count][WORLD_CHUNK_DIM];
+
+    // Walking cost between two nodes of this chunk without leaving it, PATH_UNREACHABLE if there is no way
+    uint16 IntraCost[PATH_MAX_NODES_PER_CHUNK][PATH_MAX_NODES_PER_CHUNK];
+};
+
+struct path_Step
+{
+    int16 TileX;
+    int16 TileY;
+};
+
+struct path_Result
+{
+    bool32 Found;
+    int32 StepCount;
+    path_Step Steps[PATH_MAX_STEPS];
+};
+
+struct path_Request
+{
+    int32 StartX;
+    int32 StartY;
+    int32 GoalX;
+    int32 GoalY;
+
+    path_Result* Result;
+};
+
+struct path_Graph
+{
+    path_Chunk_Graph Chunks[WORLD_CHUNK_COUNT];
+
+    // Requests are only collected during the tick and then solved all at once on the worker threads
+    int32 RequestCount;
+    path_Request Requests[PATH_MAX_REQUESTS];
+
+    // Stats of the last tick
+    int32 RebuiltChunkCount;
+    int32 SolvedRequestCount;
+};
+
+struct path_Heap_Entry
+{
+    uint32 Priority;
+    uint32 Id;
+};
+
+// Everything a single worker needs to answer requests, one per worker so they never share anything
+struct path_Scratch
+{
+    // Abstract (portal) search, entries are valid only if their stamp matches the current generation
+    uint32 Generation;
+    uint32 Stamp[PATH_ABSTRACT_NODE_COUNT + 1];
+    uint32 Closed[PATH_ABSTRACT_NODE_COUNT + 1];
+    uint32 Cost[PATH_ABSTRACT_NODE_COUNT + 1];
+    uint32 Parent[PATH_ABSTRACT_NODE_COUNT + 1];
+
+    int32 HeapCount;
+    path_Heap_Entry Heap[PATH_HEAP_CAPACITY];
+
+    // Local (tile) search inside a single chunk
+    uint32 LocalGeneration;
+    uint32 LocalStamp[WORLD_CHUNK_TILE_COUNT];
+    uint32 LocalClosed[WORLD_CHUNK_TILE_COUNT];
+    uint16 LocalCost[WORLD_CHUNK_TILE_COUNT];
+    uint16 LocalParent[WORLD_CHUNK_TILE_COUNT];
+    uint16 LocalTrace[WORLD_CHUNK_TILE_COUNT];
+
+    int32 LocalHeapCount;
+    path_Heap_Entry LocalHeap[PATH_LOCAL_HEAP_CAPACITY];
+
+    // Breadth first flood used for the portal costs
+    uint16 FloodDistance[WORLD_CHUNK_TILE_COUNT];
+    uint16 FloodQueue[WORLD_CHUNK_TILE_COUNT];
+
+    uint16 StartCost[PATH_MAX_NODES_PER_CHUNK];
+    uint16 GoalCost[PATH_MAX_NODES_PER_CHUNK];
+
+    int32 WaypointCount;
+    path_Step Waypoints[PATH_MAX_STEPS];
+};
+
+#define TERRARIA_PATHFINDING_H
+#endif
@@ -0,0 +1,37 @@
+#if !defined TERRARIA_PLATFORM_H
+
+// Shared by the game and every platform layer (the Win32 one and the headless test one), so they all build the game the same way
+
+// PUT THIS HERE TO STOP THE COMPILER FROM BITCHING
+#include <stdint.h>
+#include <math.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+
+// Macros to differentiate between all the statics
+#define internal static
+#define local_persist static
+#define global_variable static
+constexpr auto PI32 = 3.14159265359f;
+
+// typedef to ease using some of the other types of ints and uints
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+typedef int64_t int64;
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+
+typedef int32_t bool32;
+
+typedef float real32;
+typedef double real64;
+
+#define TERRARIA_PLATFORM_H
+#endif
@@ -0,0 +1,137 @@
+#if !defined TERRARIA_TEXT_H
+
+// Text for the debug overlay, floating damage numbers, and later chat and tooltips.
+// The built in font is rasterized once, at every size, into one packed atlas. A laid out string is cached by its hash,
+// so a string drawn again (the same damage number, the same tooltip line) costs only copying its quads into the batch.
+// Everything drawn during the frame is blitted in one go at the end of it
+
+#define TEXT_FIRST_CHARACTER ' '
+#define TEXT_LAST_CHARACTER '~'
+#define TEXT_GLYPH_COUNT (TEXT_LAST_CHARACTER - TEXT_FIRST_CHARACTER + 1)
+
+// Font cells are 5 pixels wide and 8 tall, the last row is for descenders
+#define TEXT_CELL_WIDTH 5
+#define TEXT_CELL_HEIGHT 8
+
+#define TEXT_ATLAS_WIDTH 512
+#define TEXT_ATLAS_HEIGHT 256
+
+#define TEXT_LAYOUT_CACHE_SIZE 4096
+#define TEXT_LAYOUT_PROBE_COUNT 8
+#define TEXT_MAX_LAYOUT_LENGTH 96
+
+#define TEXT_BATCH_SIZE 65536
+
+// What an atlas texel can be, the font is a bitmap one so there are no partial pixels
+#define TEXT_TEXEL_EMPTY 0
+#define TEXT_TEXEL_SHADOW 1
+#define TEXT_TEXEL_FILL 255
+
+#define TEXT_SHADOW_COLOR 0x00000000
+
+// The size is the integer scale of the font
+enum text_Size
+{
+    TextSize_Small,
+    TextSize_Medium,
+    TextSize_Large,
+
+    TextSize_Count,
+};
+
+struct text_Glyph
+{
+    // Tight box of the glyph in the atlas, and where it sits relative to the top of its cell
+    uint16 AtlasX;
+    uint16 AtlasY;
+    uint8 Width;
+    uint8 Height;
+    uint8 OffsetX;
+    uint8 OffsetY;
+
+    uint8 Advance;
+};
+
+struct text_Font
+{
+    int32 Scale;
+    int32 LineHeight;
+    text_Glyph Glyphs[TEXT_GLYPH_COUNT];
+};
+
+// One glyph of a laid out string, relative to the top left of the string
+struct text_Quad
+{
+    int16 X;
+    int16 Y;
+    uint16 AtlasX;
+    uint16 AtlasY;
+    uint8 Width;
+    uint8 Height;
+};
+
+struct text_Layout
+{
+    uint64 Hash;
+    uint32 LastUsedFrame;
+
+    int32 Size;
+    int32 Length;
+    char Text[TEXT_MAX_LAYOUT_LENGTH];
+
+    int32 Width;
+    int32 Height;
+    int32 QuadCount;
+    text_Quad Quads[TEXT_MAX_LAYOUT_LENGTH];
+};
+
+// A glyph waiting to be blitted, already in screen pixels
+struct text_Batch_Quad
+{
+    int16 X;
+    int16 Y;
+    uint16 AtlasX;
+    uint16 AtlasY;
+    uint8 Width;
+    uint8 Height;
+    uint32 Color;
+};
+
+struct text_State
+{
+    uint8* Atlas;
+    text_Font Fonts[TextSize_Count];
+
+    uint32 FrameIndex;
+    text_Layout* Layouts;
+
+    int32 QuadCount;
+    text_Batch_Quad* Quads;
+
+    // Stats of the last frame
+    int32 LayoutHitCount;
+    int32 LayoutMissCount;
+};
+
+// Numbers that pop up where something got hit and float away, positions are in world pixels
+#define FLOATING_NUMBER_COUNT 2048
+
+struct floating_Number
+{
+    real32 X;
+    real32 Y;
+    real32 VelocityY;
+    real32 Life;
+
+    uint32 Color;
+    char Text[12];
+};
+
+struct floating_Number_List
+{
+    int32 Count;
+    floating_Number Numbers[FLOATING_NUMBER_COUNT];
+};
+
+#define TERRARIA_TEXT_H
+#endif
@@ -0,0 +1,129 @@
+#if !defined TERRARIA_WORLD_H
+
+// The world is a grid of tiles, split into square chunks so systems can work on (and invalidate) one chunk at a time
+#define WORLD_CHUNK_SHIFT 5
+#define WORLD_CHUNK_DIM (1 << WORLD_CHUNK_SHIFT)
+#define WORLD_CHUNK_MASK (WORLD_CHUNK_DIM - 1)
+#define WORLD_CHUNK_TILE_COUNT (WORLD_CHUNK_DIM * WORLD_CHUNK_DIM)
+
+#define WORLD_CHUNK_COUNT_X 32
+#define WORLD_CHUNK_COUNT_Y 16
+#define WORLD_CHUNK_COUNT (WORLD_CHUNK_COUNT_X * WORLD_CHUNK_COUNT_Y)
+
+#define WORLD_TILE_COUNT_X (WORLD_CHUNK_COUNT_X * WORLD_CHUNK_DIM)
+#define WORLD_TILE_COUNT_Y (WORLD_CHUNK_COUNT_Y * WORLD_CHUNK_DIM)
+
+#define TILE_SIZE_IN_PIXELS 16
+
+enum tile_Type
+{
+    Tile_Air,
+    Tile_Dirt,
+    Tile_Grass,
+    Tile_Stone,
+
+    Tile_Count,
+};
+
+// Tiles are stored chunk by chunk (not row by row over the whole world) so a chunk is one contiguous block of memory
+struct world_Chunk
+{
+    uint8 Tiles[WORLD_CHUNK_TILE_COUNT];
+};
+
+struct game_World
+{
+    world_Chunk Chunks[WORLD_CHUNK_COUNT];
+};
+
+// Tile changes are never applied on the spot, they are queued during the tick and applied in one go
+// by ApplyTileEdits, which reports every chunk that actually changed in a single bitmask
+#define TILE_EDIT_QUEUE_SIZE 65536
+
+struct tile_Edit
+{
+    uint16 TileX;
+    uint16 TileY;
+    uint8 Tile;
+};
+
+struct tile_Edit_Queue
+{
+    int32 EditCount;
+    tile_Edit Edits[TILE_EDIT_QUEUE_SIZE];
+
+    // Stats of the last apply
+    int32 AppliedEditCount;
+    int32 ChangedChunkCount;
+};
+
+#define WORLD_DIRTY_MASK_WORD_COUNT ((WORLD_CHUNK_COUNT + 63) / 64)
+
+// One bit per chunk, every system that caches something about the tiles consumes the same mask
+struct world_Dirty_Mask
+{
+    uint64 Words[WORLD_DIRTY_MASK_WORD_COUNT];
+};
+
+// Chunks with a changed tile on one of their borders, one mask per side. Only systems that look across borders need these
+enum world_Border
+{
+    WorldBorder_West,
+    WorldBorder_East,
+    WorldBorder_North,
+    WorldBorder_South,
+
+    WorldBorder_Count,
+};
+
+struct world_Border_Masks
+{
+    world_Dirty_Mask Sides[WorldBorder_Count];
+};
+
+// What the renderer remembers about every chunk so it can skip the empty ones
+struct world_Render_Cache
+{
+    uint16 SolidTileCount[WORLD_CHUNK_COUNT];
+};
+
+inline void MarkChunkDirty(world_Dirty_Mask* Mask, int32 ChunkIndex)
+{
+    Mask->Words[ChunkIndex >> 6] |= (1ULL << (ChunkIndex & 63));
+}
+
+inline bool32 IsChunkDirty(world_Dirty_Mask* Mask, int32 ChunkIndex)
+{
+    return (Mask->Words[ChunkIndex >> 6] >> (ChunkIndex & 63)) & 1;
+}
+
+inline bool32 IsTileInWorld(int32 TileX, int32 TileY)
+{
+    return (TileX >= 0) && (TileY >= 0) && (TileX < WORLD_TILE_COUNT_X) && (TileY < WORLD_TILE_COUNT_Y);
+}
+
+inline int32 GetChunkIndex(int32 ChunkX, int32 ChunkY)
+{
+    return ChunkY * WORLD_CHUNK_COUNT_X + ChunkX;
+}
+
+inline uint8 GetTile(game_World* World, int32 TileX, int32 TileY)
+{
+    // Everything outside of the world counts as stone so nothing can walk (or fall) out of it
+    uint8 Result = Tile_Stone;
+    if (IsTileInWorld(TileX, TileY))
+    {
+        world_Chunk* Chunk = &World->Chunks[GetChunkIndex(TileX >> WORLD_CHUNK_SHIFT, TileY >> WORLD_CHUNK_SHIFT)];
+        Result = Chunk->Tiles[((TileY & WORLD_CHUNK_MASK) << WORLD_CHUNK_SHIFT) | (TileX & WORLD_CHUNK_MASK)];
+    }
+
+    return Result;
+}
+
+inline bool32 IsTilePassable(uint8 Tile)
+{
+    return Tile == Tile_Air;
+}
+
+#define TERRARIA_WORLD_H
+#endif
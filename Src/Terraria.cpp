@@ -1,5 +1,14 @@
 #include "../Include/Terraria.h"
 
+// Where the timed blocks write their cycle counts, set at the start of every frame
+global_variable game_Memory* DebugGlobalMemory;
+
+#include "Terraria_World.cpp"
+#include "Terraria_Pathfinding.cpp"
+#include "Terraria_Particles.cpp"
+#include "Terraria_Network.cpp"
+#include "Terraria_Text.cpp"
+
 internal void GameOutputSound(game_Sound_Output_Buffer* SoundBuffer)
 {
     local_persist real32 tSine{};
@@ -41,8 +50,338 @@ internal void Render(game_Offscreen_Buffer* buffer, int xOffset, int yOffset)
     }
 }
 
-internal void GameUpdateAndRender(game_Offscreen_Buffer* Buffer, int xOffset, int yOffset, game_Sound_Output_Buffer* SoundBuffer)
+// Fills a rectangle with a solid color, clipped against the buffer
+internal void DrawRectangle(game_Offscreen_Buffer* Buffer, int MinX, int MinY, int MaxX, int MaxY, uint32 Color)
+{
+    if (MinX < 0) { MinX = 0; }
+    if (MinY < 0) { MinY = 0; }
+    if (MaxX > Buffer->Width) { MaxX = Buffer->Width; }
+    if (MaxY > Buffer->Height) { MaxY = Buffer->Height; }
+
+    uint8* Row = (uint8*)Buffer->Memory + MinX * 4 + MinY * Buffer->Pitch;
+    for (int y = MinY; y < MaxY; ++y)
+    {
+        uint32* Pixel = (uint32*)Row;
+        for (int x = MinX; x < MaxX; ++x)
+        {
+            *Pixel++ = Color;
+        }
+
+        Row += Buffer->Pitch;
+    }
+}
+
+internal void RenderWorld(game_Offscreen_Buffer* Buffer, game_State* GameState, int CameraX, int CameraY)
+{
+    // Air is left alone so the background shows through the sky and the caves
+    uint32 TileColors[Tile_Count] = { 0, 0x00865C3A, 0x0039A845, 0x00707070 };
+
+    int MinTileX = CameraX / TILE_SIZE_IN_PIXELS;
+    int MinTileY = CameraY / TILE_SIZE_IN_PIXELS;
+    int MaxTileX = (CameraX + Buffer->Width) / TILE_SIZE_IN_PIXELS;
+    int MaxTileY = (CameraY + Buffer->Height) / TILE_SIZE_IN_PIXELS;
+
+    if (MinTileX < 0) { MinTileX = 0; }
+    if (MinTileY < 0) { MinTileY = 0; }
+    if (MaxTileX > WORLD_TILE_COUNT_X - 1) { MaxTileX = WORLD_TILE_COUNT_X - 1; }
+    if (MaxTileY > WORLD_TILE_COUNT_Y - 1) { MaxTileY = WORLD_TILE_COUNT_Y - 1; }
+
+    // Walk the visible chunks and skip the ones the render cache knows are all air
+    for (int ChunkY = (MinTileY >> WORLD_CHUNK_SHIFT); ChunkY <= (MaxTileY >> WORLD_CHUNK_SHIFT); ++ChunkY)
+    {
+        for (int ChunkX = (MinTileX >> WORLD_CHUNK_SHIFT); ChunkX <= (MaxTileX >> WORLD_CHUNK_SHIFT); ++ChunkX)
+        {
+            int32 ChunkIndex = GetChunkIndex(ChunkX, ChunkY);
+            if (GameState->RenderCache.SolidTileCount[ChunkIndex] == 0) { continue; }
+
+            uint8* Tiles = GameState->World->Chunks[ChunkIndex].Tiles;
+            for (int LocalY = 0; LocalY < WORLD_CHUNK_DIM; ++LocalY)
+            {
+                int TileY = (ChunkY << WORLD_CHUNK_SHIFT) + LocalY;
+                if ((TileY < MinTileY) || (TileY > MaxTileY)) { continue; }
+
+                for (int LocalX = 0; LocalX < WORLD_CHUNK_DIM; ++LocalX)
+                {
+                    int TileX = (ChunkX << WORLD_CHUNK_SHIFT) + LocalX;
+                    uint8 Tile = Tiles[(LocalY << WORLD_CHUNK_SHIFT) | LocalX];
+                    if ((Tile != Tile_Air) && (TileX >= MinTileX) && (TileX <= MaxTileX))
+                    {
+                        int MinX = TileX * TILE_SIZE_IN_PIXELS - CameraX;
+                        int MinY = TileY * TILE_SIZE_IN_PIXELS - CameraY;
+                        DrawRectangle(Buffer, MinX, MinY, MinX + TILE_SIZE_IN_PIXELS, MinY + TILE_SIZE_IN_PIXELS, TileColors[Tile]);
+                    }
+                }
+            }
+        }
+    }
+
+    for (int NpcIndex = 0; NpcIndex < GameState->NpcCount; ++NpcIndex)
+    {
+        game_Npc* Npc = &GameState->Npcs[NpcIndex];
+        int MinX = Npc->TileX * TILE_SIZE_IN_PIXELS - CameraX + 2;
+        int MinY = Npc->TileY * TILE_SIZE_IN_PIXELS - CameraY + 2;
+        DrawRectangle(Buffer, MinX, MinY, MinX + TILE_SIZE_IN_PIXELS - 4, MinY + TILE_SIZE_IN_PIXELS - 4, Npc->Color);
+    }
+}
+
+// Picks a random air tile around the middle of the world, gives up after a few tries
+internal bool32 FindRandomAirTile(game_State* GameState, int32* TileX, int32* TileY)
+{
+    bool32 Result = false;
+    for (int Try = 0; (Try < 16) && !Result; ++Try)
+    {
+        int32 x = RandomBetween(&GameState->Entropy, WORLD_TILE_COUNT_X / 2 - 160, WORLD_TILE_COUNT_X / 2 + 160);
+        int32 y = RandomBetween(&GameState->Entropy, WORLD_TILE_COUNT_Y / 4 - 24, WORLD_TILE_COUNT_Y / 4 + 120);
+        if (IsTilePassable(GetTile(GameState->World, x, y)))
+        {
+            *TileX = x;
+            *TileY = y;
+            Result = true;
+        }
+    }
+
+    return Result;
+}
+
+internal void UpdateNpcs(game_State* GameState, particle_System* Particles)
+{
+    for (int NpcIndex = 0; NpcIndex < GameState->NpcCount; ++NpcIndex)
+    {
+        game_Npc* Npc = &GameState->Npcs[NpcIndex];
+        if (Npc->PathStep < Npc->Path.StepCount)
+        {
+            if (--Npc->MoveCooldown <= 0)
+            {
+                path_Step Step = Npc->Path.Steps[Npc->PathStep++];
+                if (IsTilePassable(GetTile(GameState->World, Step.TileX, Step.TileY)))
+                {
+                    Npc->TileX = Step.TileX;
+                    Npc->TileY = Step.TileY;
+                    Npc->MoveCooldown = 4;
+
+                    // Kick up a little dust at the feet
+                    SpawnParticles(Particles, ParticleKind_Dust,
+                                   (real32)(Npc->TileX * TILE_SIZE_IN_PIXELS + TILE_SIZE_IN_PIXELS / 2),
+                                   (real32)((Npc->TileY + 1) * TILE_SIZE_IN_PIXELS), 4);
+                }
+                else
+                {
+                    // The world changed under the path, drop it and ask for a new one next tick
+                    Npc->Path.StepCount = 0;
+                }
+            }
+        }
+        else if (!Npc->PathPending)
+        {
+            int32 GoalX, GoalY;
+            if (FindRandomAirTile(GameState, &GoalX, &GoalY))
+            {
+                Npc->PathPending = QueuePathRequest(GameState->PathGraph, Npc->TileX, Npc->TileY, GoalX, GoalY, &Npc->Path);
+            }
+        }
+    }
+}
+
+// What used to go to the debugger output, now drawn in the top left corner every frame
+internal void DrawDebugOverlay(text_State* Text, game_Memory* Memory, game_State* GameState, transient_State* TranState)
+{
+    int32 ParticleCount = 0;
+    for (int32 Kind = 0; Kind < ParticleKind_Count; ++Kind)
+    {
+        ParticleCount += TranState->Particles.Pools[Kind].Count;
+    }
+
+    char Line[TEXT_MAX_LAYOUT_LENGTH];
+    int32 LineHeight = Text->Fonts[TextSize_Small].LineHeight;
+    int32 Y = 4;
+
+    snprintf(Line, sizeof(Line), "%dms/frame, %dframes/second, %dmegacycles/frame",
+             Memory->LastMillisecondsPerFrame, Memory->LastFramesPerSecond, Memory->LastMegaCyclesPerFrame);
+    DrawString(Text, TextSize_Small, 4, Y, 0x00FFFFFF, Line);
+    Y += LineHeight;
+
+    snprintf(Line, sizeof(Line), "tick %u, %d npcs, %d particles, %d numbers",
+             GameState->TickIndex, GameState->NpcCount, ParticleCount, TranState->FloatingNumbers.Count);
+    DrawString(Text, TextSize_Small, 4, Y, 0x00FFFFFF, Line);
+    Y += LineHeight;
+
+    snprintf(Line, sizeof(Line), "net %d bytes/tick, text layouts %d cached %d new",
+             GameState->Server->BytesSent, Text->LayoutHitCount, Text->LayoutMissCount);
+    DrawString(Text, TextSize_Small, 4, Y, 0x00FFFFFF, Line);
+}
+
+internal void GameUpdateAndRender(game_Memory* Memory, game_Offscreen_Buffer* Buffer, int xOffset, int yOffset, game_Sound_Output_Buffer* SoundBuffer)
 {
+    DebugGlobalMemory = Memory;
+    BEGIN_TIMED_BLOCK(GameUpdateAndRender);
+
+    Assert(sizeof(game_State) <= Memory->PermanentStorageSize);
+    game_State* GameState = (game_State*)Memory->PermanentStorage;
+    if (!Memory->IsInitialized)
+    {
+        InitializeArena(&GameState->WorldArena,
+                        (size_t)(Memory->PermanentStorageSize - sizeof(game_State)),
+                        (uint8*)Memory->PermanentStorage + sizeof(game_State));
+
+        GameState->Entropy.State = 0x1F2E3D4C;
+
+        GameState->World = PushStruct(&GameState->WorldArena, game_World);
+        GenerateWorld(GameState->World, &GameState->Entropy);
+
+        GameState->PathGraph = PushStruct(&GameState->WorldArena, path_Graph);
+        GameState->TileEdits = PushStruct(&GameState->WorldArena, tile_Edit_Queue);
+
+        // A brand new world has never been seen by any of the systems that cache tiles
+        MarkAllChunksDirty(&GameState->DirtyChunks);
+
+        GameState->Loopback = PushStruct(&GameState->WorldArena, net_Loopback);
+        InitializeLoopbackTransport(&GameState->LoopbackTransport, GameState->Loopback);
+
+        GameState->Server = PushStruct(&GameState->WorldArena, net_Server);
+        GameState->Server->Transport = &GameState->LoopbackTransport;
+        for (int ClientIndex = 0; ClientIndex < NET_LOOPBACK_CLIENT_COUNT; ++ClientIndex)
+        {
+            GameState->Clients[ClientIndex] = PushStruct(&GameState->WorldArena, net_Client);
+            InitializeClient(GameState->Clients[ClientIndex], ClientIndex, &GameState->LoopbackTransport);
+            ConnectClient(GameState->Server, ClientIndex);
+        }
+
+        for (int NpcIndex = 0; NpcIndex < NPC_COUNT; ++NpcIndex)
+        {
+            game_Npc* Npc = &GameState->Npcs[GameState->NpcCount];
+            if (FindRandomAirTile(GameState, &Npc->TileX, &Npc->TileY))
+            {
+                Npc->Color = 0x00FF0000 | (RandomNext(&GameState->Entropy) & 0x0000FFFF);
+                ++GameState->NpcCount;
+            }
+        }
+
+        Memory->IsInitialized = true;
+    }
+
+    // The state may come from an autosave written by an earlier run, where the code was loaded at another address
+    InitializeLoopbackTransport(&GameState->LoopbackTransport, GameState->Loopback);
+
+    Assert(sizeof(transient_State) <= Memory->TransientStorageSize);
+    transient_State* TranState = (transient_State*)Memory->TransientStorage;
+    if (!TranState->IsInitialized)
+    {
+        InitializeArena(&TranState->TransientArena,
+                        (size_t)(Memory->TransientStorageSize - sizeof(transient_State)),
+                        (uint8*)Memory->TransientStorage + sizeof(transient_State));
+
+        for (int WorkerIndex = 0; WorkerIndex < PATH_WORKER_COUNT; ++WorkerIndex)
+        {
+            TranState->PathScratch[WorkerIndex] = PushStruct(&TranState->TransientArena, path_Scratch);
+        }
+
+        int32 ParticleCapacities[ParticleKind_Count] = { 131072, 32768, 32768, 32768 };
+        InitializeParticleSystem(&TranState->Particles, &TranState->TransientArena, ParticleCapacities);
+
+        InitializeText(&TranState->Text, &TranState->TransientArena);
+
+        TranState->IsInitialized = true;
+    }
+
+    // Ticks start at 1, 0 means "never" for everything that remembers when something happened
+    ++GameState->TickIndex;
+    BeginText(&TranState->Text);
+
+#if TERRARIA_BENCHMARK
+    // Blow a hole somewhere around the middle of the world every tick to stress the bulk edit path
+    {
+        int32 x = RandomBetween(&GameState->Entropy, WORLD_TILE_COUNT_X / 2 - 160, WORLD_TILE_COUNT_X / 2 + 160);
+        int32 y = RandomBetween(&GameState->Entropy, WORLD_TILE_COUNT_Y / 4, WORLD_TILE_COUNT_Y / 4 + 120);
+        QueueTileCircle(GameState->TileEdits, x, y, 12, Tile_Air);
+        SpawnParticles(&TranState->Particles, ParticleKind_Debris,
+                       (real32)(x * TILE_SIZE_IN_PIXELS), (real32)(y * TILE_SIZE_IN_PIXELS), 256);
+    }
+#endif
+
+    // Apply all the tile edits queued since the last tick, then let every system that caches tiles catch up on the
+    // chunks that changed. Lighting and liquids will consume the same mask once they exist
+    BEGIN_TIMED_BLOCK(ApplyTileEdits);
+    int32 EditCount = GameState->TileEdits->EditCount;
+    ApplyTileEdits(GameState->World, GameState->TileEdits, &GameState->DirtyChunks, &GameState->DirtyBorders);
+    UpdateWorldRenderCache(&GameState->RenderCache, GameState->World, &GameState->DirtyChunks);
+    InvalidatePathChunks(GameState->PathGraph, &GameState->DirtyChunks, &GameState->DirtyBorders);
+    NoteChangedChunks(GameState->Server, &GameState->DirtyChunks, GameState->TickIndex);
+    ClearDirtyMask(&GameState->DirtyChunks);
+    for (int32 Side = 0; Side < WorldBorder_Count; ++Side)
+    {
+        ClearDirtyMask(&GameState->DirtyBorders.Sides[Side]);
+    }
+    END_TIMED_BLOCK_COUNTED(ApplyTileEdits, EditCount);
+
+    // Pathfinding: bring the portal graph up to date, let the NPCs queue their requests, then solve them all at once
+    BEGIN_TIMED_BLOCK(UpdatePathGraph);
+    UpdatePathGraph(GameState->PathGraph, GameState->World, TranState->PathScratch, Memory);
+    END_TIMED_BLOCK_COUNTED(UpdatePathGraph, GameState->PathGraph->RebuiltChunkCount);
+
+    UpdateNpcs(GameState, &TranState->Particles);
+
+    BEGIN_TIMED_BLOCK(ProcessPathRequests);
+    ProcessPathRequests(GameState->PathGraph, GameState->World, TranState->PathScratch, Memory);
+    END_TIMED_BLOCK_COUNTED(ProcessPathRequests, GameState->PathGraph->SolvedRequestCount);
+    for (int NpcIndex = 0; NpcIndex < GameState->NpcCount; ++NpcIndex)
+    {
+        game_Npc* Npc = &GameState->Npcs[NpcIndex];
+        if (Npc->PathPending)
+        {
+            Npc->PathPending = false;
+            Npc->PathStep = 0;
+        }
+    }
+
+    // Replication: take in the acks from last tick, send this tick's snapshots, and let the loopback clients decode them
+    ServerReceiveAcks(GameState->Server);
+    for (int ClientIndex = 0; ClientIndex < NET_LOOPBACK_CLIENT_COUNT; ++ClientIndex)
+    {
+        if (ClientIndex < GameState->NpcCount)
+        {
+            GameState->Server->Clients[ClientIndex].PlayerTileX = GameState->Npcs[ClientIndex].TileX;
+            GameState->Server->Clients[ClientIndex].PlayerTileY = GameState->Npcs[ClientIndex].TileY;
+        }
+    }
+    ServerSendSnapshots(GameState->Server, GameState->World, GameState->Npcs, GameState->NpcCount, GameState->TickIndex);
+    for (int ClientIndex = 0; ClientIndex < NET_LOOPBACK_CLIENT_COUNT; ++ClientIndex)
+    {
+        ClientReceiveSnapshots(GameState->Clients[ClientIndex]);
+    }
+
+    int CameraX = (WORLD_TILE_COUNT_X / 2) * TILE_SIZE_IN_PIXELS - Buffer->Width / 2 + xOffset;
+    int CameraY = (WORLD_TILE_COUNT_Y / 4) * TILE_SIZE_IN_PIXELS - Buffer->Height / 2 + yOffset;
+
+#if TERRARIA_BENCHMARK
+    // Keep well over 100k particles alive spread across the screen
+    for (int Burst = 0; Burst < 64; ++Burst)
+    {
+        real32 x = (real32)CameraX + RandomUnilateral(&TranState->Particles.Entropy) * (real32)Buffer->Width;
+        real32 y = (real32)CameraY + RandomUnilateral(&TranState->Particles.Entropy) * (real32)Buffer->Height;
+        SpawnParticles(&TranState->Particles, Burst % ParticleKind_Count, x, y, 48);
+
+        // Keeps around a thousand damage numbers on screen
+        if ((Burst % 4) == 0)
+        {
+            SpawnFloatingNumber(&TranState->FloatingNumbers, x, y, RandomBetween(&TranState->Particles.Entropy, 1, 999), 0x00FFE060);
+        }
+    }
+#endif
+
+    UpdateParticles(&TranState->Particles, 1.0f / (real32)GAME_UPDATE_HZ);
+    UpdateFloatingNumbers(&TranState->FloatingNumbers, 1.0f / (real32)GAME_UPDATE_HZ);
+
     GameOutputSound(SoundBuffer);
     Render(Buffer, xOffset, yOffset);
-}
\ No newline at end of file
+    RenderWorld(Buffer, GameState, CameraX, CameraY);
+    RenderParticles(Buffer, &TranState->Particles, CameraX, CameraY);
+
+    BEGIN_TIMED_BLOCK(RenderText);
+    DrawFloatingNumbers(&TranState->Text, &TranState->FloatingNumbers, CameraX, CameraY);
+    DrawDebugOverlay(&TranState->Text, Memory, GameState, TranState);
+    int32 TextQuadCount = TranState->Text.QuadCount;
+    FlushText(Buffer, &TranState->Text);
+    END_TIMED_BLOCK_COUNTED(RenderText, TextQuadCount);
+
+    END_TIMED_BLOCK(GameUpdateAndRender);
+}
@@ -0,0 +1,511 @@
+#include "../Include/Terraria_Network.h"
+
+#include <string.h>
+
+// Bits needed for the quantized fields, the world has to fit in them
+#define NET_TILE_X_BITS 10
+#define NET_TILE_Y_BITS 9
+#define NET_CHUNK_INDEX_BITS 9
+#define NET_TILE_TYPE_BITS 2
+#define NET_COLOR_BITS 24
+
+static_assert((1 << NET_TILE_X_BITS) >= WORLD_TILE_COUNT_X, "NET_TILE_X_BITS is too small for the world");
+static_assert((1 << NET_TILE_Y_BITS) >= WORLD_TILE_COUNT_Y, "NET_TILE_Y_BITS is too small for the world");
+static_assert((1 << NET_CHUNK_INDEX_BITS) >= WORLD_CHUNK_COUNT, "NET_CHUNK_INDEX_BITS is too small for the world");
+static_assert((1 << NET_TILE_TYPE_BITS) >= Tile_Count, "NET_TILE_TYPE_BITS is too small for the tile types");
+static_assert(DEBUG_NET_CLIENT_COUNT >= NET_MAX_CLIENTS, "DEBUG_NET_CLIENT_COUNT is too small for the clients");
+
+//
+// Loopback transport
+//
+
+internal NET_SEND(LoopbackSend)
+{
+    net_Loopback* Loopback = (net_Loopback*)Transport->Data;
+    net_Loopback_Channel* LoopbackChannel = &Loopback->Channels[Channel];
+
+    // Hash the packet number so the drops do not line up with the fixed order packets are sent in every tick
+    uint32 PacketHash = (uint32)(++Loopback->SentCount) * 2654435761u;
+    bool32 Dropped = (Loopback->DropEvery > 0) && (((PacketHash >> 16) % Loopback->DropEvery) == 0);
+
+    int32 NextWriteIndex = (LoopbackChannel->WriteIndex + 1) % NET_LOOPBACK_QUEUE_SIZE;
+    bool32 Sent = !Dropped && (Size <= NET_MAX_PACKET_SIZE) && (NextWriteIndex != LoopbackChannel->ReadIndex);
+    if (Sent)
+    {
+        memcpy(LoopbackChannel->Packets[LoopbackChannel->WriteIndex], Data, Size);
+        LoopbackChannel->Sizes[LoopbackChannel->WriteIndex] = Size;
+        LoopbackChannel->WriteIndex = NextWriteIndex;
+    }
+
+    return Sent;
+}
+
+internal NET_RECEIVE(LoopbackReceive)
+{
+    net_Loopback* Loopback = (net_Loopback*)Transport->Data;
+    net_Loopback_Channel* LoopbackChannel = &Loopback->Channels[Channel];
+
+    int32 Size = 0;
+    if (LoopbackChannel->ReadIndex != LoopbackChannel->WriteIndex)
+    {
+        Size = LoopbackChannel->Sizes[LoopbackChannel->ReadIndex];
+        if (Size > BufferSize) { Size = BufferSize; }
+
+        memcpy(Buffer, LoopbackChannel->Packets[LoopbackChannel->ReadIndex], Size);
+        LoopbackChannel->ReadIndex = (LoopbackChannel->ReadIndex + 1) % NET_LOOPBACK_QUEUE_SIZE;
+    }
+
+    return Size;
+}
+
+internal void InitializeLoopbackTransport(net_Transport* Transport, net_Loopback* Loopback)
+{
+    Transport->Send = LoopbackSend;
+    Transport->Receive = LoopbackReceive;
+    Transport->Data = Loopback;
+}
+
+//
+// Bit packing
+//
+
+struct net_Bit_Writer
+{
+    uint8* Base;
+    uint8* At;
+    uint8* End;
+
+    uint64 Accumulator;
+    int32 AccumulatedBits;
+    bool32 Overflow;
+};
+
+struct net_Bit_Reader
+{
+    uint8* At;
+    uint8* End;
+
+    uint64 Accumulator;
+    int32 AccumulatedBits;
+    bool32 Overflow;
+};
+
+internal net_Bit_Writer BeginBitWriter(void* Buffer, int32 Size)
+{
+    net_Bit_Writer Writer = {};
+    Writer.Base = (uint8*)Buffer;
+    Writer.At = Writer.Base;
+    Writer.End = Writer.Base + Size;
+
+    return Writer;
+}
+
+// Count is at most 32, only the low Count bits of Value are written
+internal void WriteBits(net_Bit_Writer* Writer, uint32 Value, int32 Count)
+{
+    uint64 Mask = (Count == 32) ? 0xFFFFFFFFULL : ((1ULL << Count) - 1);
+    Writer->Accumulator |= ((uint64)Value & Mask) << Writer->AccumulatedBits;
+    Writer->AccumulatedBits += Count;
+
+    while (Writer->AccumulatedBits >= 8)
+    {
+        if (Writer->At < Writer->End) { *Writer->At++ = (uint8)Writer->Accumulator; }
+        else                          { Writer->Overflow = true; }
+
+        Writer->Accumulator >>= 8;
+        Writer->AccumulatedBits -= 8;
+    }
+}
+
+// Pads the last byte and returns the size in bytes
+internal int32 EndBitWriter(net_Bit_Writer* Writer)
+{
+    if (Writer->AccumulatedBits > 0)
+    {
+        WriteBits(Writer, 0, 8 - Writer->AccumulatedBits);
+    }
+
+    return (int32)(Writer->At - Writer->Base);
+}
+
+internal int32 GetBytesLeft(net_Bit_Writer* Writer)
+{
+    return (int32)(Writer->End - Writer->At) - 1;
+}
+
+internal net_Bit_Reader BeginBitReader(void* Buffer, int32 Size)
+{
+    net_Bit_Reader Reader = {};
+    Reader.At = (uint8*)Buffer;
+    Reader.End = Reader.At + Size;
+
+    return Reader;
+}
+
+internal uint32 ReadBits(net_Bit_Reader* Reader, int32 Count)
+{
+    while (Reader->AccumulatedBits < Count)
+    {
+        uint64 Byte = 0;
+        if (Reader->At < Reader->End) { Byte = *Reader->At++; }
+        else                          { Reader->Overflow = true; }
+
+        Reader->Accumulator |= Byte << Reader->AccumulatedBits;
+        Reader->AccumulatedBits += 8;
+    }
+
+    uint64 Mask = (Count == 32) ? 0xFFFFFFFFULL : ((1ULL << Count) - 1);
+    uint32 Result = (uint32)(Reader->Accumulator & Mask);
+    Reader->Accumulator >>= Count;
+    Reader->AccumulatedBits -= Count;
+
+    return Result;
+}
+
+//
+// Encoding, the decoder below mirrors every one of these
+//
+
+inline bool32 EntityStatesMatch(net_Entity_State* A, net_Entity_State* B)
+{
+    return (A->Present == B->Present) && (A->TileX == B->TileX) && (A->TileY == B->TileY) && (A->Color == B->Color);
+}
+
+internal void WriteEntityDelta(net_Bit_Writer* Writer, net_Entity_State* Baseline, net_Entity_State* State)
+{
+    bool32 Changed = !EntityStatesMatch(Baseline, State);
+    WriteBits(Writer, Changed, 1);
+    if (Changed)
+    {
+        WriteBits(Writer, State->Present, 1);
+        if (State->Present)
+        {
+            // Walking NPCs mostly move a tile or two, so small moves only take 4 bits per axis
+            int32 dx = State->TileX - Baseline->TileX;
+            int32 dy = State->TileY - Baseline->TileY;
+            bool32 SmallMove = (dx >= -8) && (dx <= 7) && (dy >= -8) && (dy <= 7);
+            WriteBits(Writer, SmallMove, 1);
+            if (SmallMove)
+            {
+                WriteBits(Writer, dx + 8, 4);
+                WriteBits(Writer, dy + 8, 4);
+            }
+            else
+            {
+                WriteBits(Writer, State->TileX, NET_TILE_X_BITS);
+                WriteBits(Writer, State->TileY, NET_TILE_Y_BITS);
+            }
+
+            bool32 ColorChanged = (State->Color != Baseline->Color);
+            WriteBits(Writer, ColorChanged, 1);
+            if (ColorChanged)
+            {
+                WriteBits(Writer, State->Color, NET_COLOR_BITS);
+            }
+        }
+    }
+}
+
+internal void ReadEntityDelta(net_Bit_Reader* Reader, net_Entity_State* Baseline, net_Entity_State* State)
+{
+    *State = *Baseline;
+    if (ReadBits(Reader, 1))
+    {
+        net_Entity_State Empty = {};
+        *State = Empty;
+        State->Present = ReadBits(Reader, 1);
+        if (State->Present)
+        {
+            if (ReadBits(Reader, 1))
+            {
+                State->TileX = Baseline->TileX + (int32)ReadBits(Reader, 4) - 8;
+                State->TileY = Baseline->TileY + (int32)ReadBits(Reader, 4) - 8;
+            }
+            else
+            {
+                State->TileX = ReadBits(Reader, NET_TILE_X_BITS);
+                State->TileY = ReadBits(Reader, NET_TILE_Y_BITS);
+            }
+
+            State->Color = ReadBits(Reader, 1) ? ReadBits(Reader, NET_COLOR_BITS) : Baseline->Color;
+        }
+    }
+}
+
+// Chunks are mostly long runs of the same tile, short runs take 7 bits and long ones 13
+internal void WriteChunk(net_Bit_Writer* Writer, world_Chunk* Chunk, int32 ChunkIndex)
+{
+    WriteBits(Writer, ChunkIndex, NET_CHUNK_INDEX_BITS);
+
+    int32 TileIndex = 0;
+    while (TileIndex < WORLD_CHUNK_TILE_COUNT)
+    {
+        uint8 Tile = Chunk->Tiles[TileIndex];
+        int32 RunLength = 1;
+        while (((TileIndex + RunLength) < WORLD_CHUNK_TILE_COUNT) && (Chunk->Tiles[TileIndex + RunLength] == Tile))
+        {
+            ++RunLength;
+        }
+
+        WriteBits(Writer, Tile, NET_TILE_TYPE_BITS);
+        if (RunLength <= 16)
+        {
+            WriteBits(Writer, 0, 1);
+            WriteBits(Writer, RunLength - 1, 4);
+        }
+        else
+        {
+            WriteBits(Writer, 1, 1);
+            WriteBits(Writer, RunLength - 1, 10);
+        }
+
+        TileIndex += RunLength;
+    }
+}
+
+// A chunk index outside the world means the packet is corrupt, it is flagged like a short read so the snapshot gets thrown away
+internal void ReadChunk(net_Bit_Reader* Reader, game_World* World)
+{
+    int32 ChunkIndex = ReadBits(Reader, NET_CHUNK_INDEX_BITS);
+    if (ChunkIndex >= WORLD_CHUNK_COUNT)
+    {
+        Reader->Overflow = true;
+        return;
+    }
+    world_Chunk* Chunk = &World->Chunks[ChunkIndex];
+
+    int32 TileIndex = 0;
+    while ((TileIndex < WORLD_CHUNK_TILE_COUNT) && !Reader->Overflow)
+    {
+        uint8 Tile = (uint8)ReadBits(Reader, NET_TILE_TYPE_BITS);
+        int32 RunLength = 1 + (ReadBits(Reader, 1) ? ReadBits(Reader, 10) : ReadBits(Reader, 4));
+        if (RunLength > (WORLD_CHUNK_TILE_COUNT - TileIndex)) { RunLength = WORLD_CHUNK_TILE_COUNT - TileIndex; }
+
+        memset(Chunk->Tiles + TileIndex, Tile, RunLength);
+        TileIndex += RunLength;
+    }
+}
+
+//
+// Server
+//
+
+internal void ConnectClient(net_Server* Server, int32 ClientIndex)
+{
+    net_Server_Client* Client = &Server->Clients[ClientIndex];
+    memset(Client, 0, sizeof(*Client));
+    Client->Connected = true;
+}
+
+// Consumer of the world dirty mask, remembers when every chunk last changed
+internal void NoteChangedChunks(net_Server* Server, world_Dirty_Mask* DirtyMask, uint32 Tick)
+{
+    for (int32 WordIndex = 0; WordIndex < WORLD_DIRTY_MASK_WORD_COUNT; ++WordIndex)
+    {
+        for (uint64 Word = DirtyMask->Words[WordIndex]; Word; Word &= Word - 1)
+        {
+            Server->ChunkChangedTick[WordIndex * 64 + FindLowestSetBit(Word)] = Tick;
+        }
+    }
+}
+
+internal void ServerReceiveAcks(net_Server* Server)
+{
+    for (int32 ClientIndex = 0; ClientIndex < NET_MAX_CLIENTS; ++ClientIndex)
+    {
+        net_Server_Client* Client = &Server->Clients[ClientIndex];
+
+        uint32 AckedTick;
+        while (Server->Transport->Receive(Server->Transport, GetChannelToServer(ClientIndex), &AckedTick, sizeof(AckedTick)) == sizeof(AckedTick))
+        {
+            net_Sent_Snapshot* Sent = &Client->History[AckedTick % NET_SNAPSHOT_HISTORY];
+            if (Client->Connected && (AckedTick > Client->LastAckedTick) && (Sent->Tick == AckedTick))
+            {
+                Client->LastAckedTick = AckedTick;
+                for (int32 Index = 0; Index < Sent->ChunkCount; ++Index)
+                {
+                    Client->ChunkAckedTick[Sent->Chunks[Index]] = AckedTick;
+                }
+            }
+        }
+    }
+}
+
+inline bool32 IsChunkInInterest(int32 ChunkX, int32 ChunkY, int32 CenterChunkX, int32 CenterChunkY)
+{
+    int32 dx = ChunkX - CenterChunkX;
+    int32 dy = ChunkY - CenterChunkY;
+    return (dx >= -NET_INTEREST_RADIUS) && (dx <= NET_INTEREST_RADIUS) && (dy >= -NET_INTEREST_RADIUS) && (dy <= NET_INTEREST_RADIUS);
+}
+
+internal int32 EncodeSnapshot(net_Server* Server, net_Server_Client* Client, game_World* World, game_Npc* Npcs, int32 NpcCount,
+                              uint32 Tick, void* Buffer)
+{
+    int32 CenterChunkX = Client->PlayerTileX >> WORLD_CHUNK_SHIFT;
+    int32 CenterChunkY = Client->PlayerTileY >> WORLD_CHUNK_SHIFT;
+
+    // Deltas are against the last snapshot the client acknowledged, or against nothing if that one is gone
+    net_Sent_Snapshot* Baseline = &Client->History[Client->LastAckedTick % NET_SNAPSHOT_HISTORY];
+    bool32 HaveBaseline = Client->LastAckedTick && (Baseline->Tick == Client->LastAckedTick) &&
+                          ((Tick - Client->LastAckedTick) < NET_SNAPSHOT_HISTORY);
+    uint32 BaselineTick = HaveBaseline ? Client->LastAckedTick : 0;
+    net_Entity_State Empty = {};
+
+    net_Sent_Snapshot* Sent = &Client->History[Tick % NET_SNAPSHOT_HISTORY];
+    Sent->Tick = Tick;
+    Sent->ChunkCount = 0;
+
+    net_Bit_Writer Writer = BeginBitWriter(Buffer, NET_MAX_PACKET_SIZE);
+    WriteBits(&Writer, Tick, 32);
+    WriteBits(&Writer, BaselineTick, 32);
+
+    for (int32 EntityIndex = 0; EntityIndex < NET_MAX_ENTITIES; ++EntityIndex)
+    {
+        net_Entity_State* State = &Sent->Entities[EntityIndex];
+        *State = Empty;
+        if (EntityIndex < NpcCount)
+        {
+            game_Npc* Npc = &Npcs[EntityIndex];
+            if (IsChunkInInterest(Npc->TileX >> WORLD_CHUNK_SHIFT, Npc->TileY >> WORLD_CHUNK_SHIFT, CenterChunkX, CenterChunkY))
+            {
+                State->Present = true;
+                State->TileX = Npc->TileX;
+                State->TileY = Npc->TileY;
+                State->Color = Npc->Color & 0x00FFFFFF;
+            }
+        }
+
+        WriteEntityDelta(&Writer, BaselineTick ? &Baseline->Entities[EntityIndex] : &Empty, State);
+    }
+
+    // Closest chunks first so the ones right around the player win when the packet fills up.
+    // A chunk the client has not acknowledged is only sent again once the previous send had time to be acknowledged
+    for (int32 Ring = 0; Ring <= NET_INTEREST_RADIUS; ++Ring)
+    {
+        for (int32 ChunkY = CenterChunkY - Ring; ChunkY <= CenterChunkY + Ring; ++ChunkY)
+        {
+            for (int32 ChunkX = CenterChunkX - Ring; ChunkX <= CenterChunkX + Ring; ++ChunkX)
+            {
+                bool32 OnRing = (ChunkX == CenterChunkX - Ring) || (ChunkX == CenterChunkX + Ring) ||
+                                (ChunkY == CenterChunkY - Ring) || (ChunkY == CenterChunkY + Ring);
+                bool32 InWorld = (ChunkX >= 0) && (ChunkY >= 0) && (ChunkX < WORLD_CHUNK_COUNT_X) && (ChunkY < WORLD_CHUNK_COUNT_Y);
+                if (!OnRing || !InWorld) { continue; }
+
+                int32 ChunkIndex = GetChunkIndex(ChunkX, ChunkY);
+                uint32 ChangedTick = Server->ChunkChangedTick[ChunkIndex];
+                bool32 ClientIsBehind = (ChangedTick > Client->ChunkAckedTick[ChunkIndex]);
+                bool32 WaitingForAck = (Client->ChunkSentTick[ChunkIndex] >= ChangedTick) &&
+                                       ((Tick - Client->ChunkSentTick[ChunkIndex]) < NET_RESEND_TICKS);
+
+                if (ClientIsBehind && !WaitingForAck &&
+                    (Sent->ChunkCount < NET_MAX_CHUNKS_PER_SNAPSHOT) && (GetBytesLeft(&Writer) >= NET_MAX_CHUNK_BYTES))
+                {
+                    WriteBits(&Writer, 1, 1);
+                    WriteChunk(&Writer, &World->Chunks[ChunkIndex], ChunkIndex);
+
+                    Client->ChunkSentTick[ChunkIndex] = Tick;
+                    Sent->Chunks[Sent->ChunkCount++] = (uint16)ChunkIndex;
+                }
+            }
+        }
+    }
+    WriteBits(&Writer, 0, 1);
+
+    int32 Size = EndBitWriter(&Writer);
+    Assert(!Writer.Overflow);
+
+    return Size;
+}
+
+// Writes and sends this tick's snapshot to every connected client
+internal void ServerSendSnapshots(net_Server* Server, game_World* World, game_Npc* Npcs, int32 NpcCount, uint32 Tick)
+{
+    int32 ClientCount = 0;
+    BEGIN_TIMED_BLOCK(EncodeSnapshots);
+
+    uint8 Packet[NET_MAX_PACKET_SIZE];
+    Server->BytesSent = 0;
+    for (int32 ClientIndex = 0; ClientIndex < NET_MAX_CLIENTS; ++ClientIndex)
+    {
+        net_Server_Client* Client = &Server->Clients[ClientIndex];
+        if (Client->Connected)
+        {
+            int32 Size = EncodeSnapshot(Server, Client, World, Npcs, NpcCount, Tick, Packet);
+            Server->Transport->Send(Server->Transport, GetChannelToClient(ClientIndex), Packet, Size);
+
+            Client->BytesSent = Size;
+            Client->ChunksSent = Client->History[Tick % NET_SNAPSHOT_HISTORY].ChunkCount;
+            Server->BytesSent += Size;
+            ++ClientCount;
+
+            debug_Net_Counter* NetCounter = &DebugGlobalMemory->NetCounters[ClientIndex];
+            ++NetCounter->TickCount;
+            NetCounter->BytesSent += Client->BytesSent;
+            NetCounter->ChunksSent += Client->ChunksSent;
+        }
+    }
+
+    END_TIMED_BLOCK_COUNTED(EncodeSnapshots, ClientCount);
+}
+
+//
+// Client
+//
+
+internal void InitializeClient(net_Client* Client, int32 ClientIndex, net_Transport* Transport)
+{
+    memset(Client, 0, sizeof(*Client));
+    Client->ClientIndex = ClientIndex;
+    Client->Transport = Transport;
+
+    // Until the server says otherwise everything is solid rock
+    memset(Client->World.Chunks, Tile_Stone, sizeof(Client->World.Chunks));
+}
+
+// Decodes every snapshot that arrived and acknowledges the newest one it could use
+internal void ClientReceiveSnapshots(net_Client* Client)
+{
+    uint8 Packet[NET_MAX_PACKET_SIZE];
+    int32 Size;
+    while ((Size = Client->Transport->Receive(Client->Transport, GetChannelToClient(Client->ClientIndex), Packet, sizeof(Packet))) > 0)
+    {
+        net_Bit_Reader Reader = BeginBitReader(Packet, Size);
+        uint32 Tick = ReadBits(&Reader, 32);
+        uint32 BaselineTick = ReadBits(&Reader, 32);
+
+        // Old snapshots and ones built on a baseline we no longer have are useless, the server will catch up from the last ack
+        net_Received_Snapshot* Baseline = &Client->History[BaselineTick % NET_SNAPSHOT_HISTORY];
+        bool32 HaveBaseline = (BaselineTick == 0) ||
+                              ((Baseline->Tick == BaselineTick) && ((Tick - BaselineTick) < NET_SNAPSHOT_HISTORY));
+        if ((Tick <= Client->LatestTick) || !HaveBaseline)
+        {
+            continue;
+        }
+
+        net_Received_Snapshot* Received = &Client->History[Tick % NET_SNAPSHOT_HISTORY];
+        net_Entity_State Empty = {};
+        Received->Tick = 0;
+        for (int32 EntityIndex = 0; EntityIndex < NET_MAX_ENTITIES; ++EntityIndex)
+        {
+            ReadEntityDelta(&Reader, BaselineTick ? &Baseline->Entities[EntityIndex] : &Empty, &Received->Entities[EntityIndex]);
+        }
+
+        while (!Reader.Overflow && ReadBits(&Reader, 1))
+        {
+            ReadChunk(&Reader, &Client->World);
+        }
+
+        // A truncated or corrupt snapshot is neither used as a baseline nor acknowledged. Chunks decoded before the bad part
+        // are still what the server sent, and since they are not acknowledged the server sends them again
+        if (Reader.Overflow)
+        {
+            continue;
+        }
+
+        Received->Tick = Tick;
+        Client->LatestTick = Tick;
+        memcpy(Client->Entities, Received->Entities, sizeof(Client->Entities));
+
+        Client->Transport->Send(Client->Transport, GetChannelToServer(Client->ClientIndex), &Tick, sizeof(Tick));
+    }
+}
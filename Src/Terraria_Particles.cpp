@@ -0,0 +1,206 @@
+#include "../Include/Terraria_Particles.h"
+
+#include <emmintrin.h>
+
+// How a freshly spawned particle of every kind looks and moves
+struct particle_Spawn_Info
+{
+    real32 Gravity;
+    real32 Drag;
+
+    real32 MinSpeed;
+    real32 MaxSpeed;
+    real32 MinLife;
+    real32 MaxLife;
+
+    uint32 Color;
+};
+
+global_variable particle_Spawn_Info ParticleSpawnInfo[ParticleKind_Count] =
+{
+    //  Gravity  Drag    MinSpeed  MaxSpeed  MinLife  MaxLife  Color
+    {   200.0f,  0.96f,  10.0f,    60.0f,    0.6f,    1.2f,    0x00A0804A },  // Dust
+    {   400.0f,  0.99f,  120.0f,   320.0f,   0.2f,    0.5f,    0x00FFD040 },  // Spark
+    {   900.0f,  0.995f, 60.0f,    240.0f,   1.0f,    2.0f,    0x00865C3A },  // Debris
+    {   700.0f,  0.99f,  40.0f,    180.0f,   0.4f,    0.9f,    0x004080FF },  // Splash
+};
+
+internal void InitializeParticleSystem(particle_System* System, memory_Arena* Arena, int32* Capacities)
+{
+    System->Entropy.State = 0x7A3B9C11;
+
+    for (int32 Kind = 0; Kind < ParticleKind_Count; ++Kind)
+    {
+        particle_Pool* Pool = &System->Pools[Kind];
+
+        // Round up so the SIMD loops can always work on whole groups of four
+        Pool->Count = 0;
+        Pool->Capacity = (Capacities[Kind] + 3) & ~3;
+        Pool->PositionX = PushArray(Arena, Pool->Capacity, real32);
+        Pool->PositionY = PushArray(Arena, Pool->Capacity, real32);
+        Pool->VelocityX = PushArray(Arena, Pool->Capacity, real32);
+        Pool->VelocityY = PushArray(Arena, Pool->Capacity, real32);
+        Pool->Life = PushArray(Arena, Pool->Capacity, real32);
+        Pool->Color = PushArray(Arena, Pool->Capacity, uint32);
+
+        Pool->Gravity = ParticleSpawnInfo[Kind].Gravity;
+        Pool->Drag = ParticleSpawnInfo[Kind].Drag;
+    }
+}
+
+// Spawns up to Count particles at a world pixel position, silently drops whatever does not fit in the pool
+internal void SpawnParticles(particle_System* System, int32 Kind, real32 x, real32 y, int32 Count)
+{
+    particle_Pool* Pool = &System->Pools[Kind];
+    particle_Spawn_Info* Info = &ParticleSpawnInfo[Kind];
+    random_Series* Series = &System->Entropy;
+
+    if (Count > (Pool->Capacity - Pool->Count))
+    {
+        Count = Pool->Capacity - Pool->Count;
+    }
+
+    for (int32 SpawnIndex = 0; SpawnIndex < Count; ++SpawnIndex)
+    {
+        int32 Index = Pool->Count++;
+        real32 Angle = RandomUnilateral(Series) * 2.0f * PI32;
+        real32 Speed = Info->MinSpeed + (Info->MaxSpeed - Info->MinSpeed) * RandomUnilateral(Series);
+
+        Pool->PositionX[Index] = x;
+        Pool->PositionY[Index] = y;
+        Pool->VelocityX[Index] = Speed * cosf(Angle);
+        Pool->VelocityY[Index] = Speed * sinf(Angle);
+        Pool->Life[Index] = Info->MinLife + (Info->MaxLife - Info->MinLife) * RandomUnilateral(Series);
+        Pool->Color[Index] = Info->Color;
+    }
+}
+
+internal void UpdateParticlePool(particle_Pool* Pool, real32 dt)
+{
+    // Integrate four particles at a time, the lanes past Count are padding and nobody reads them
+    __m128 dt_4x = _mm_set1_ps(dt);
+    __m128 Gravity_4x = _mm_set1_ps(Pool->Gravity * dt);
+    __m128 Drag_4x = _mm_set1_ps(Pool->Drag);
+
+    for (int32 Index = 0; Index < Pool->Count; Index += 4)
+    {
+        __m128 VelocityX = _mm_mul_ps(_mm_load_ps(Pool->VelocityX + Index), Drag_4x);
+        __m128 VelocityY = _mm_mul_ps(_mm_add_ps(_mm_load_ps(Pool->VelocityY + Index), Gravity_4x), Drag_4x);
+        __m128 PositionX = _mm_add_ps(_mm_load_ps(Pool->PositionX + Index), _mm_mul_ps(VelocityX, dt_4x));
+        __m128 PositionY = _mm_add_ps(_mm_load_ps(Pool->PositionY + Index), _mm_mul_ps(VelocityY, dt_4x));
+        __m128 Life = _mm_sub_ps(_mm_load_ps(Pool->Life + Index), dt_4x);
+
+        _mm_store_ps(Pool->VelocityX + Index, VelocityX);
+        _mm_store_ps(Pool->VelocityY + Index, VelocityY);
+        _mm_store_ps(Pool->PositionX + Index, PositionX);
+        _mm_store_ps(Pool->PositionY + Index, PositionY);
+        _mm_store_ps(Pool->Life + Index, Life);
+    }
+
+    // Cull the dead ones by moving the last particle into their slot, whole groups of living particles are skipped at once.
+    // The particle moved in is checked again since it could be dead too
+    __m128 Zero = _mm_setzero_ps();
+    int32 Index = 0;
+    while (Index < Pool->Count)
+    {
+        if ((Index + 4) <= Pool->Count)
+        {
+            int DeadMask = _mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(Pool->Life + Index), Zero));
+            if (DeadMask == 0)
+            {
+                Index += 4;
+                continue;
+            }
+        }
+
+        if (Pool->Life[Index] <= 0.0f)
+        {
+            int32 Last = --Pool->Count;
+            Pool->PositionX[Index] = Pool->PositionX[Last];
+            Pool->PositionY[Index] = Pool->PositionY[Last];
+            Pool->VelocityX[Index] = Pool->VelocityX[Last];
+            Pool->VelocityY[Index] = Pool->VelocityY[Last];
+            Pool->Life[Index] = Pool->Life[Last];
+            Pool->Color[Index] = Pool->Color[Last];
+        }
+        else
+        {
+            ++Index;
+        }
+    }
+}
+
+internal void UpdateParticles(particle_System* System, real32 dt)
+{
+    int32 ParticleCount = 0;
+    BEGIN_TIMED_BLOCK(UpdateParticles);
+    for (int32 Kind = 0; Kind < ParticleKind_Count; ++Kind)
+    {
+        ParticleCount += System->Pools[Kind].Count;
+        UpdateParticlePool(&System->Pools[Kind], dt);
+    }
+    END_TIMED_BLOCK_COUNTED(UpdateParticles, ParticleCount);
+}
+
+// Every particle is a 2x2 block written straight into the buffer, no blending
+internal void RenderParticles(game_Offscreen_Buffer* Buffer, particle_System* System, int CameraX, int CameraY)
+{
+    int32 ParticleCount = 0;
+    BEGIN_TIMED_BLOCK(RenderParticles);
+
+    // Anything that would land outside (or on the last row/column, since it is 2 pixels wide) gets clipped
+    __m128 CameraX_4x = _mm_set1_ps((real32)CameraX);
+    __m128 CameraY_4x = _mm_set1_ps((real32)CameraY);
+    __m128i MaxX_4x = _mm_set1_epi32(Buffer->Width - 1);
+    __m128i MaxY_4x = _mm_set1_epi32(Buffer->Height - 1);
+    __m128i MinusOne = _mm_set1_epi32(-1);
+
+    for (int32 Kind = 0; Kind < ParticleKind_Count; ++Kind)
+    {
+        particle_Pool* Pool = &System->Pools[Kind];
+        ParticleCount += Pool->Count;
+
+        for (int32 Index = 0; Index < Pool->Count; Index += 4)
+        {
+            // Floor instead of truncating so particles just left/above the screen do not snap onto it
+            __m128 ScreenXf = _mm_sub_ps(_mm_load_ps(Pool->PositionX + Index), CameraX_4x);
+            __m128 ScreenYf = _mm_sub_ps(_mm_load_ps(Pool->PositionY + Index), CameraY_4x);
+            __m128i ScreenX = _mm_cvttps_epi32(ScreenXf);
+            __m128i ScreenY = _mm_cvttps_epi32(ScreenYf);
+            ScreenX = _mm_add_epi32(ScreenX, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(ScreenXf, _mm_cvtepi32_ps(ScreenX))), MinusOne));
+            ScreenY = _mm_add_epi32(ScreenY, _mm_and_si128(_mm_castps_si128(_mm_cmplt_ps(ScreenYf, _mm_cvtepi32_ps(ScreenY))), MinusOne));
+
+            __m128i Inside = _mm_and_si128(_mm_and_si128(_mm_cmpgt_epi32(ScreenX, MinusOne), _mm_cmplt_epi32(ScreenX, MaxX_4x)),
+                                           _mm_and_si128(_mm_cmpgt_epi32(ScreenY, MinusOne), _mm_cmplt_epi32(ScreenY, MaxY_4x)));
+            int InsideMask = _mm_movemask_ps(_mm_castsi128_ps(Inside));
+
+            int32 LaneCount = Pool->Count - Index;
+            if (LaneCount > 4) { LaneCount = 4; }
+            InsideMask &= (1 << LaneCount) - 1;
+
+            if (InsideMask)
+            {
+                int32 X[4];
+                int32 Y[4];
+                _mm_storeu_si128((__m128i*)X, ScreenX);
+                _mm_storeu_si128((__m128i*)Y, ScreenY);
+
+                for (int32 Lane = 0; Lane < 4; ++Lane)
+                {
+                    if (InsideMask & (1 << Lane))
+                    {
+                        uint32 Color = Pool->Color[Index + Lane];
+                        uint32* Pixel = (uint32*)((uint8*)Buffer->Memory + Y[Lane] * Buffer->Pitch + X[Lane] * 4);
+                        Pixel[0] = Color;
+                        Pixel[1] = Color;
+                        Pixel = (uint32*)((uint8*)Pixel + Buffer->Pitch);
+                        Pixel[0] = Color;
+                        Pixel[1] = Color;
+                    }
+                }
+            }
+        }
+    }
+
+    END_TIMED_BLOCK_COUNTED(RenderParticles, ParticleCount);
+}
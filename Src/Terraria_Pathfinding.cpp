@@ -0,0 +1,653 @@
+#include "../Include/Terraria_Pathfinding.h"
+
+// Tile inside the chunk at a given position along one of its sides
+internal uint16 GetSideTile(int32 Side, int32 Offset)
+{
+    int32 x = Offset;
+    int32 y = Offset;
+    switch (Side)
+    {
+        case PathSide_West:  { x = 0; } break;
+        case PathSide_East:  { x = WORLD_CHUNK_DIM - 1; } break;
+        case PathSide_North: { y = 0; } break;
+        case PathSide_South: { y = WORLD_CHUNK_DIM - 1; } break;
+    }
+
+    return (uint16)((y << WORLD_CHUNK_SHIFT) | x);
+}
+
+// Sides are laid out in opposite pairs, so flipping the lowest bit gives the other side of a border
+inline int32 GetOppositeSide(int32 Side)
+{
+    return Side ^ 1;
+}
+
+internal bool32 GetNeighborChunk(int32 ChunkIndex, int32 Side, int32* NeighborIndex)
+{
+    int32 ChunkX = ChunkIndex % WORLD_CHUNK_COUNT_X;
+    int32 ChunkY = ChunkIndex / WORLD_CHUNK_COUNT_X;
+    switch (Side)
+    {
+        case PathSide_West:  { --ChunkX; } break;
+        case PathSide_East:  { ++ChunkX; } break;
+        case PathSide_North: { --ChunkY; } break;
+        case PathSide_South: { ++ChunkY; } break;
+    }
+
+    bool32 Result = (ChunkX >= 0) && (ChunkY >= 0) && (ChunkX < WORLD_CHUNK_COUNT_X) && (ChunkY < WORLD_CHUNK_COUNT_Y);
+    if (Result)
+    {
+        *NeighborIndex = GetChunkIndex(ChunkX, ChunkY);
+    }
+
+    return Result;
+}
+
+internal path_Step GetWorldStep(int32 ChunkIndex, uint16 LocalTile)
+{
+    path_Step Result;
+    Result.TileX = (int16)(((ChunkIndex % WORLD_CHUNK_COUNT_X) << WORLD_CHUNK_SHIFT) + (LocalTile & WORLD_CHUNK_MASK));
+    Result.TileY = (int16)(((ChunkIndex / WORLD_CHUNK_COUNT_X) << WORLD_CHUNK_SHIFT) + (LocalTile >> WORLD_CHUNK_SHIFT));
+
+    return Result;
+}
+
+inline uint32 GetManhattanDistance(int32 ax, int32 ay, int32 bx, int32 by)
+{
+    int32 dx = ax - bx;
+    int32 dy = ay - by;
+    return (uint32)(((dx < 0) ? -dx : dx) + ((dy < 0) ? -dy : dy));
+}
+
+// Binary min-heap on the priority, used by both levels of the search
+internal bool32 HeapPush(path_Heap_Entry* Heap, int32* Count, int32 Capacity, uint32 Priority, uint32 Id)
+{
+    bool32 Result = (*Count < Capacity);
+    if (Result)
+    {
+        int32 Index = (*Count)++;
+        while (Index > 0)
+        {
+            int32 ParentIndex = (Index - 1) / 2;
+            if (Heap[ParentIndex].Priority <= Priority) { break; }
+
+            Heap[Index] = Heap[ParentIndex];
+            Index = ParentIndex;
+        }
+
+        Heap[Index].Priority = Priority;
+        Heap[Index].Id = Id;
+    }
+
+    return Result;
+}
+
+internal path_Heap_Entry HeapPop(path_Heap_Entry* Heap, int32* Count)
+{
+    path_Heap_Entry Result = Heap[0];
+    path_Heap_Entry Last = Heap[--(*Count)];
+
+    int32 Index = 0;
+    for (;;)
+    {
+        int32 ChildIndex = Index * 2 + 1;
+        if (ChildIndex >= *Count) { break; }
+        if ((ChildIndex + 1 < *Count) && (Heap[ChildIndex + 1].Priority < Heap[ChildIndex].Priority)) { ++ChildIndex; }
+        if (Last.Priority <= Heap[ChildIndex].Priority) { break; }
+
+        Heap[Index] = Heap[ChildIndex];
+        Index = ChildIndex;
+    }
+
+    if (*Count > 0)
+    {
+        Heap[Index] = Last;
+    }
+
+    return Result;
+}
+
+// Breadth first flood from one tile over the passable tiles of a chunk, fills FloodDistance
+internal void FloodChunk(game_World* World, int32 ChunkIndex, uint16 StartTile, path_Scratch* Scratch)
+{
+    uint8* Tiles = World->Chunks[ChunkIndex].Tiles;
+    uint16* Distance = Scratch->FloodDistance;
+    uint16* Queue = Scratch->FloodQueue;
+
+    for (int32 TileIndex = 0; TileIndex < WORLD_CHUNK_TILE_COUNT; ++TileIndex)
+    {
+        Distance[TileIndex] = PATH_UNREACHABLE;
+    }
+
+    if (IsTilePassable(Tiles[StartTile]))
+    {
+        int32 Head = 0;
+        int32 Tail = 0;
+        Distance[StartTile] = 0;
+        Queue[Tail++] = StartTile;
+
+        while (Head < Tail)
+        {
+            uint16 Tile = Queue[Head++];
+            int32 x = Tile & WORLD_CHUNK_MASK;
+            int32 y = Tile >> WORLD_CHUNK_SHIFT;
+            uint16 NextDistance = Distance[Tile] + 1;
+
+            uint16 Neighbors[4];
+            int32 NeighborCount = 0;
+            if (x > 0)                   { Neighbors[NeighborCount++] = Tile - 1; }
+            if (x < WORLD_CHUNK_DIM - 1) { Neighbors[NeighborCount++] = Tile + 1; }
+            if (y > 0)                   { Neighbors[NeighborCount++] = Tile - WORLD_CHUNK_DIM; }
+            if (y < WORLD_CHUNK_DIM - 1) { Neighbors[NeighborCount++] = Tile + WORLD_CHUNK_DIM; }
+
+            for (int32 NeighborIndex = 0; NeighborIndex < NeighborCount; ++NeighborIndex)
+            {
+                uint16 Neighbor = Neighbors[NeighborIndex];
+                if ((Distance[Neighbor] == PATH_UNREACHABLE) && IsTilePassable(Tiles[Neighbor]))
+                {
+                    Distance[Neighbor] = NextDistance;
+                    Queue[Tail++] = Neighbor;
+                }
+            }
+        }
+    }
+}
+
+internal void AddPortalNode(path_Chunk_Graph* ChunkGraph, int32 Side, int32 Offset)
+{
+    if (ChunkGraph->NodeCount < PATH_MAX_NODES_PER_CHUNK)
+    {
+        int32 NodeIndex = ChunkGraph->NodeCount++;
+        ChunkGraph->NodeTile[NodeIndex] = GetSideTile(Side, Offset);
+        ChunkGraph->NodeSide[NodeIndex] = (uint8)Side;
+        ChunkGraph->NodeOffset[NodeIndex] = (uint8)Offset;
+        ChunkGraph->NodeAt[Side][Offset] = (uint8)NodeIndex;
+    }
+}
+
+internal void RebuildChunkGraph(path_Graph* Graph, game_World* World, int32 ChunkIndex, path_Scratch* Scratch)
+{
+    path_Chunk_Graph* ChunkGraph = &Graph->Chunks[ChunkIndex];
+    uint8* InsideTiles = World->Chunks[ChunkIndex].Tiles;
+
+    ChunkGraph->NodeCount = 0;
+    for (int32 Side = 0; Side < PathSide_Count; ++Side)
+    {
+        for (int32 Offset = 0; Offset < WORLD_CHUNK_DIM; ++Offset)
+        {
+            ChunkGraph->NodeAt[Side][Offset] = PATH_NO_NODE;
+        }
+    }
+
+    // Find the open stretches along every border, both chunks of a border see the same tiles so they agree on the portals
+    for (int32 Side = 0; Side < PathSide_Count; ++Side)
+    {
+        int32 NeighborIndex;
+        if (GetNeighborChunk(ChunkIndex, Side, &NeighborIndex))
+        {
+            uint8* OutsideTiles = World->Chunks[NeighborIndex].Tiles;
+            int32 OppositeSide = GetOppositeSide(Side);
+
+            int32 RunStart = -1;
+            for (int32 Offset = 0; Offset <= WORLD_CHUNK_DIM; ++Offset)
+            {
+                bool32 Open = (Offset < WORLD_CHUNK_DIM) &&
+                              IsTilePassable(InsideTiles[GetSideTile(Side, Offset)]) &&
+                              IsTilePassable(OutsideTiles[GetSideTile(OppositeSide, Offset)]);
+
+                if (Open && (RunStart < 0))
+                {
+                    RunStart = Offset;
+                }
+                else if (!Open && (RunStart >= 0))
+                {
+                    // Long openings get a portal at each end, short ones a single portal in the middle
+                    int32 RunEnd = Offset - 1;
+                    if ((RunEnd - RunStart + 1) >= 8)
+                    {
+                        AddPortalNode(ChunkGraph, Side, RunStart);
+                        AddPortalNode(ChunkGraph, Side, RunEnd);
+                    }
+                    else
+                    {
+                        AddPortalNode(ChunkGraph, Side, (RunStart + RunEnd) / 2);
+                    }
+
+                    RunStart = -1;
+                }
+            }
+        }
+    }
+
+    // Cache the walking cost between every pair of portals of this chunk
+    for (int32 NodeIndex = 0; NodeIndex < ChunkGraph->NodeCount; ++NodeIndex)
+    {
+        FloodChunk(World, ChunkIndex, ChunkGraph->NodeTile[NodeIndex], Scratch);
+        for (int32 OtherIndex = 0; OtherIndex < ChunkGraph->NodeCount; ++OtherIndex)
+        {
+            ChunkGraph->IntraCost[NodeIndex][OtherIndex] = Scratch->FloodDistance[ChunkGraph->NodeTile[OtherIndex]];
+        }
+    }
+
+    ChunkGraph->IsDirty = false;
+}
+
+internal bool32 AppendStep(path_Result* Result, path_Step Step)
+{
+    bool32 Appended = (Result->StepCount < PATH_MAX_STEPS);
+    if (Appended)
+    {
+        Result->Steps[Result->StepCount++] = Step;
+    }
+
+    return Appended;
+}
+
+// A* over the tiles of a single chunk, appends the steps after From up to and including To
+internal bool32 FindLocalPath(game_World* World, int32 ChunkIndex, uint16 From, uint16 To, path_Scratch* Scratch, path_Result* Result)
+{
+    uint8* Tiles = World->Chunks[ChunkIndex].Tiles;
+
+    if (++Scratch->LocalGeneration == 0)
+    {
+        for (int32 TileIndex = 0; TileIndex < WORLD_CHUNK_TILE_COUNT; ++TileIndex)
+        {
+            Scratch->LocalStamp[TileIndex] = 0;
+            Scratch->LocalClosed[TileIndex] = 0;
+        }
+        Scratch->LocalGeneration = 1;
+    }
+    uint32 Generation = Scratch->LocalGeneration;
+
+    int32 ToX = To & WORLD_CHUNK_MASK;
+    int32 ToY = To >> WORLD_CHUNK_SHIFT;
+
+    Scratch->LocalHeapCount = 0;
+    Scratch->LocalStamp[From] = Generation;
+    Scratch->LocalCost[From] = 0;
+    Scratch->LocalParent[From] = From;
+    HeapPush(Scratch->LocalHeap, &Scratch->LocalHeapCount, PATH_LOCAL_HEAP_CAPACITY,
+             GetManhattanDistance(From & WORLD_CHUNK_MASK, From >> WORLD_CHUNK_SHIFT, ToX, ToY), From);
+
+    bool32 Found = false;
+    while (Scratch->LocalHeapCount > 0)
+    {
+        uint16 Tile = (uint16)HeapPop(Scratch->LocalHeap, &Scratch->LocalHeapCount).Id;
+        if (Scratch->LocalClosed[Tile] == Generation) { continue; }
+        Scratch->LocalClosed[Tile] = Generation;
+
+        if (Tile == To)
+        {
+            Found = true;
+            break;
+        }
+
+        int32 x = Tile & WORLD_CHUNK_MASK;
+        int32 y = Tile >> WORLD_CHUNK_SHIFT;
+        uint16 NextCost = Scratch->LocalCost[Tile] + 1;
+
+        uint16 Neighbors[4];
+        int32 NeighborCount = 0;
+        if (x > 0)                   { Neighbors[NeighborCount++] = Tile - 1; }
+        if (x < WORLD_CHUNK_DIM - 1) { Neighbors[NeighborCount++] = Tile + 1; }
+        if (y > 0)                   { Neighbors[NeighborCount++] = Tile - WORLD_CHUNK_DIM; }
+        if (y < WORLD_CHUNK_DIM - 1) { Neighbors[NeighborCount++] = Tile + WORLD_CHUNK_DIM; }
+
+        for (int32 NeighborIndex = 0; NeighborIndex < NeighborCount; ++NeighborIndex)
+        {
+            uint16 Neighbor = Neighbors[NeighborIndex];
+            if (IsTilePassable(Tiles[Neighbor]) &&
+                ((Scratch->LocalStamp[Neighbor] != Generation) || (NextCost < Scratch->LocalCost[Neighbor])))
+            {
+                Scratch->LocalStamp[Neighbor] = Generation;
+                Scratch->LocalCost[Neighbor] = NextCost;
+                Scratch->LocalParent[Neighbor] = Tile;
+
+                uint32 Priority = NextCost + GetManhattanDistance(Neighbor & WORLD_CHUNK_MASK, Neighbor >> WORLD_CHUNK_SHIFT, ToX, ToY);
+                HeapPush(Scratch->LocalHeap, &Scratch->LocalHeapCount, PATH_LOCAL_HEAP_CAPACITY, Priority, Neighbor);
+            }
+        }
+    }
+
+    if (Found)
+    {
+        // Walk back from the goal, then append in the right order
+        int32 TraceCount = 0;
+        for (uint16 Tile = To; Tile != From; Tile = Scratch->LocalParent[Tile])
+        {
+            Scratch->LocalTrace[TraceCount++] = Tile;
+        }
+
+        while (TraceCount > 0)
+        {
+            if (!AppendStep(Result, GetWorldStep(ChunkIndex, Scratch->LocalTrace[--TraceCount]))) { break; }
+        }
+    }
+
+    return Found;
+}
+
+internal path_Step GetNodeStep(path_Graph* Graph, uint32 NodeId)
+{
+    int32 ChunkIndex = NodeId / PATH_MAX_NODES_PER_CHUNK;
+    int32 NodeIndex = NodeId % PATH_MAX_NODES_PER_CHUNK;
+
+    return GetWorldStep(ChunkIndex, Graph->Chunks[ChunkIndex].NodeTile[NodeIndex]);
+}
+
+internal void RelaxNode(path_Scratch* Scratch, uint32 NodeId, uint32 Cost, uint32 ParentId, uint32 Heuristic)
+{
+    if ((Scratch->Stamp[NodeId] != Scratch->Generation) || (Cost < Scratch->Cost[NodeId]))
+    {
+        Scratch->Stamp[NodeId] = Scratch->Generation;
+        Scratch->Cost[NodeId] = Cost;
+        Scratch->Parent[NodeId] = ParentId;
+        HeapPush(Scratch->Heap, &Scratch->HeapCount, PATH_HEAP_CAPACITY, Cost + Heuristic, NodeId);
+    }
+}
+
+internal void FindPath(path_Graph* Graph, game_World* World, path_Scratch* Scratch, path_Request* Request)
+{
+    path_Result* Result = Request->Result;
+    Result->Found = false;
+    Result->StepCount = 0;
+
+    if (!IsTilePassable(GetTile(World, Request->StartX, Request->StartY)) ||
+        !IsTilePassable(GetTile(World, Request->GoalX, Request->GoalY)))
+    {
+        return;
+    }
+
+    int32 StartChunk = GetChunkIndex(Request->StartX >> WORLD_CHUNK_SHIFT, Request->StartY >> WORLD_CHUNK_SHIFT);
+    int32 GoalChunk = GetChunkIndex(Request->GoalX >> WORLD_CHUNK_SHIFT, Request->GoalY >> WORLD_CHUNK_SHIFT);
+    uint16 StartTile = (uint16)(((Request->StartY & WORLD_CHUNK_MASK) << WORLD_CHUNK_SHIFT) | (Request->StartX & WORLD_CHUNK_MASK));
+    uint16 GoalTile = (uint16)(((Request->GoalY & WORLD_CHUNK_MASK) << WORLD_CHUNK_SHIFT) | (Request->GoalX & WORLD_CHUNK_MASK));
+
+    // Short trips that stay inside one chunk never touch the portal graph
+    if ((StartChunk == GoalChunk) &&
+        ((StartTile == GoalTile) || FindLocalPath(World, StartChunk, StartTile, GoalTile, Scratch, Result)))
+    {
+        Result->Found = true;
+        return;
+    }
+
+    // Hook the start and goal tile up to the portals of their chunks
+    path_Chunk_Graph* StartGraph = &Graph->Chunks[StartChunk];
+    path_Chunk_Graph* GoalGraph = &Graph->Chunks[GoalChunk];
+
+    FloodChunk(World, StartChunk, StartTile, Scratch);
+    for (int32 NodeIndex = 0; NodeIndex < StartGraph->NodeCount; ++NodeIndex)
+    {
+        Scratch->StartCost[NodeIndex] = Scratch->FloodDistance[StartGraph->NodeTile[NodeIndex]];
+    }
+
+    FloodChunk(World, GoalChunk, GoalTile, Scratch);
+    for (int32 NodeIndex = 0; NodeIndex < GoalGraph->NodeCount; ++NodeIndex)
+    {
+        Scratch->GoalCost[NodeIndex] = Scratch->FloodDistance[GoalGraph->NodeTile[NodeIndex]];
+    }
+
+    // A* over the portal graph, the goal tile gets its own id right after the last portal
+    if (++Scratch->Generation == 0)
+    {
+        for (int32 NodeId = 0; NodeId <= PATH_ABSTRACT_NODE_COUNT; ++NodeId)
+        {
+            Scratch->Stamp[NodeId] = 0;
+            Scratch->Closed[NodeId] = 0;
+        }
+        Scratch->Generation = 1;
+    }
+
+    uint32 GoalId = PATH_ABSTRACT_NODE_COUNT;
+    uint32 NoParent = 0xFFFFFFFF;
+    Scratch->HeapCount = 0;
+
+    for (int32 NodeIndex = 0; NodeIndex < StartGraph->NodeCount; ++NodeIndex)
+    {
+        if (Scratch->StartCost[NodeIndex] != PATH_UNREACHABLE)
+        {
+            uint32 NodeId = StartChunk * PATH_MAX_NODES_PER_CHUNK + NodeIndex;
+            path_Step NodeStep = GetNodeStep(Graph, NodeId);
+            RelaxNode(Scratch, NodeId, Scratch->StartCost[NodeIndex], NoParent,
+                      GetManhattanDistance(NodeStep.TileX, NodeStep.TileY, Request->GoalX, Request->GoalY));
+        }
+    }
+
+    bool32 Found = false;
+    while (Scratch->HeapCount > 0)
+    {
+        uint32 NodeId = HeapPop(Scratch->Heap, &Scratch->HeapCount).Id;
+        if (Scratch->Closed[NodeId] == Scratch->Generation) { continue; }
+        Scratch->Closed[NodeId] = Scratch->Generation;
+
+        if (NodeId == GoalId)
+        {
+            Found = true;
+            break;
+        }
+
+        int32 ChunkIndex = NodeId / PATH_MAX_NODES_PER_CHUNK;
+        int32 NodeIndex = NodeId % PATH_MAX_NODES_PER_CHUNK;
+        path_Chunk_Graph* ChunkGraph = &Graph->Chunks[ChunkIndex];
+        uint32 Cost = Scratch->Cost[NodeId];
+
+        if ((ChunkIndex == GoalChunk) && (Scratch->GoalCost[NodeIndex] != PATH_UNREACHABLE))
+        {
+            RelaxNode(Scratch, GoalId, Cost + Scratch->GoalCost[NodeIndex], NodeId, 0);
+        }
+
+        // Portals of the same chunk
+        for (int32 OtherIndex = 0; OtherIndex < ChunkGraph->NodeCount; ++OtherIndex)
+        {
+            uint16 IntraCost = ChunkGraph->IntraCost[NodeIndex][OtherIndex];
+            if ((OtherIndex != NodeIndex) && (IntraCost != PATH_UNREACHABLE))
+            {
+                uint32 OtherId = ChunkIndex * PATH_MAX_NODES_PER_CHUNK + OtherIndex;
+                path_Step OtherStep = GetNodeStep(Graph, OtherId);
+                RelaxNode(Scratch, OtherId, Cost + IntraCost, NodeId,
+                          GetManhattanDistance(OtherStep.TileX, OtherStep.TileY, Request->GoalX, Request->GoalY));
+            }
+        }
+
+        // The matching portal on the other side of the border is always a single step away
+        int32 Side = ChunkGraph->NodeSide[NodeIndex];
+        int32 NeighborIndex;
+        if (GetNeighborChunk(ChunkIndex, Side, &NeighborIndex))
+        {
+            uint8 Partner = Graph->Chunks[NeighborIndex].NodeAt[GetOppositeSide(Side)][ChunkGraph->NodeOffset[NodeIndex]];
+            if (Partner != PATH_NO_NODE)
+            {
+                uint32 PartnerId = NeighborIndex * PATH_MAX_NODES_PER_CHUNK + Partner;
+                path_Step PartnerStep = GetNodeStep(Graph, PartnerId);
+                RelaxNode(Scratch, PartnerId, Cost + 1, NodeId,
+                          GetManhattanDistance(PartnerStep.TileX, PartnerStep.TileY, Request->GoalX, Request->GoalY));
+            }
+        }
+    }
+
+    if (!Found)
+    {
+        return;
+    }
+
+    // Collect the portals from the goal back to the start
+    Scratch->WaypointCount = 0;
+    path_Step GoalStep = { (int16)Request->GoalX, (int16)Request->GoalY };
+    Scratch->Waypoints[Scratch->WaypointCount++] = GoalStep;
+    for (uint32 NodeId = Scratch->Parent[GoalId]; NodeId != NoParent; NodeId = Scratch->Parent[NodeId])
+    {
+        if (Scratch->WaypointCount == PATH_MAX_STEPS - 1)
+        {
+            return;
+        }
+        Scratch->Waypoints[Scratch->WaypointCount++] = GetNodeStep(Graph, NodeId);
+    }
+    path_Step StartStep = { (int16)Request->StartX, (int16)Request->StartY };
+    Scratch->Waypoints[Scratch->WaypointCount++] = StartStep;
+
+    // Refine every leg back into tiles, legs either stay inside one chunk or cross a border in one step.
+    // Paths longer than PATH_MAX_STEPS get cut off, the NPC asks again once it reaches the end
+    for (int32 WaypointIndex = Scratch->WaypointCount - 1; WaypointIndex > 0; --WaypointIndex)
+    {
+        path_Step From = Scratch->Waypoints[WaypointIndex];
+        path_Step To = Scratch->Waypoints[WaypointIndex - 1];
+        if ((From.TileX == To.TileX) && (From.TileY == To.TileY)) { continue; }
+
+        int32 FromChunk = GetChunkIndex(From.TileX >> WORLD_CHUNK_SHIFT, From.TileY >> WORLD_CHUNK_SHIFT);
+        int32 ToChunk = GetChunkIndex(To.TileX >> WORLD_CHUNK_SHIFT, To.TileY >> WORLD_CHUNK_SHIFT);
+        if (FromChunk != ToChunk)
+        {
+            if (!AppendStep(Result, To)) { break; }
+        }
+        else
+        {
+            uint16 FromTile = (uint16)(((From.TileY & WORLD_CHUNK_MASK) << WORLD_CHUNK_SHIFT) | (From.TileX & WORLD_CHUNK_MASK));
+            uint16 ToTile = (uint16)(((To.TileY & WORLD_CHUNK_MASK) << WORLD_CHUNK_SHIFT) | (To.TileX & WORLD_CHUNK_MASK));
+            if (!FindLocalPath(World, FromChunk, FromTile, ToTile, Scratch, Result) ||
+                (Result->StepCount == PATH_MAX_STEPS))
+            {
+                break;
+            }
+        }
+    }
+
+    Result->Found = true;
+}
+
+static_assert(((int32)PathSide_West == (int32)WorldBorder_West) && ((int32)PathSide_East == (int32)WorldBorder_East) &&
+              ((int32)PathSide_North == (int32)WorldBorder_North) && ((int32)PathSide_South == (int32)WorldBorder_South),
+              "Path sides and world borders have to be in the same order");
+
+// The costs inside a chunk only depend on its own tiles, but the portals on a border depend on the tiles of both chunks along it.
+// So a changed chunk is rebuilt, and a neighbor only when the change was on the border they share
+internal void InvalidatePathChunks(path_Graph* Graph, world_Dirty_Mask* DirtyMask, world_Border_Masks* BorderMasks)
+{
+    for (int32 WordIndex = 0; WordIndex < WORLD_DIRTY_MASK_WORD_COUNT; ++WordIndex)
+    {
+        for (uint64 Word = DirtyMask->Words[WordIndex]; Word; Word &= Word - 1)
+        {
+            Graph->Chunks[WordIndex * 64 + FindLowestSetBit(Word)].IsDirty = true;
+        }
+    }
+
+    for (int32 Side = 0; Side < PathSide_Count; ++Side)
+    {
+        world_Dirty_Mask* BorderMask = &BorderMasks->Sides[Side];
+        for (int32 WordIndex = 0; WordIndex < WORLD_DIRTY_MASK_WORD_COUNT; ++WordIndex)
+        {
+            for (uint64 Word = BorderMask->Words[WordIndex]; Word; Word &= Word - 1)
+            {
+                int32 NeighborIndex;
+                if (GetNeighborChunk(WordIndex * 64 + FindLowestSetBit(Word), Side, &NeighborIndex))
+                {
+                    Graph->Chunks[NeighborIndex].IsDirty = true;
+                }
+            }
+        }
+    }
+}
+
+internal bool32 QueuePathRequest(path_Graph* Graph, int32 StartX, int32 StartY, int32 GoalX, int32 GoalY, path_Result* Result)
+{
+    bool32 Queued = (Graph->RequestCount < PATH_MAX_REQUESTS);
+    if (Queued)
+    {
+        path_Request* Request = &Graph->Requests[Graph->RequestCount++];
+        Request->StartX = StartX;
+        Request->StartY = StartY;
+        Request->GoalX = GoalX;
+        Request->GoalY = GoalY;
+        Request->Result = Result;
+    }
+
+    return Queued;
+}
+
+// A slice of work for one worker, either dirty chunks to rebuild or requests to solve
+struct path_Job
+{
+    path_Graph* Graph;
+    game_World* World;
+    path_Scratch* Scratch;
+
+    int32* ChunkIndices;
+    int32 First;
+    int32 Count;
+};
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(DoPathRebuildJob)
+{
+    path_Job* Job = (path_Job*)Data;
+    for (int32 Index = Job->First; Index < Job->First + Job->Count; ++Index)
+    {
+        RebuildChunkGraph(Job->Graph, Job->World, Job->ChunkIndices[Index], Job->Scratch);
+    }
+}
+
+internal PLATFORM_WORK_QUEUE_CALLBACK(DoPathRequestJob)
+{
+    path_Job* Job = (path_Job*)Data;
+    for (int32 Index = Job->First; Index < Job->First + Job->Count; ++Index)
+    {
+        FindPath(Job->Graph, Job->World, Job->Scratch, &Job->Graph->Requests[Index]);
+    }
+}
+
+// Splits Count items into one contiguous slice per worker and waits until all of them are done
+internal void RunPathJobs(path_Graph* Graph, game_World* World, path_Scratch** Scratch, game_Memory* Memory,
+                          platform_Work_Queue_Callback* Callback, int32* ChunkIndices, int32 Count)
+{
+    path_Job Jobs[PATH_WORKER_COUNT];
+    int32 PerJob = (Count + PATH_WORKER_COUNT - 1) / PATH_WORKER_COUNT;
+
+    for (int32 JobIndex = 0; JobIndex < PATH_WORKER_COUNT; ++JobIndex)
+    {
+        path_Job* Job = &Jobs[JobIndex];
+        Job->Graph = Graph;
+        Job->World = World;
+        Job->Scratch = Scratch[JobIndex];
+        Job->ChunkIndices = ChunkIndices;
+        Job->First = JobIndex * PerJob;
+        Job->Count = Count - Job->First;
+        if (Job->Count > PerJob) { Job->Count = PerJob; }
+
+        if (Job->Count > 0)
+        {
+            Memory->PlatformAddEntry(Memory->WorkQueue, Callback, Job);
+        }
+    }
+
+    Memory->PlatformCompleteAllWork(Memory->WorkQueue);
+}
+
+// Brings the portal graph up to date, only the chunks flagged dirty since the last tick are rebuilt
+internal void UpdatePathGraph(path_Graph* Graph, game_World* World, path_Scratch** Scratch, game_Memory* Memory)
+{
+    int32 DirtyChunks[WORLD_CHUNK_COUNT];
+    int32 DirtyCount = 0;
+    for (int32 ChunkIndex = 0; ChunkIndex < WORLD_CHUNK_COUNT; ++ChunkIndex)
+    {
+        if (Graph->Chunks[ChunkIndex].IsDirty)
+        {
+            DirtyChunks[DirtyCount++] = ChunkIndex;
+        }
+    }
+
+    Graph->RebuiltChunkCount = DirtyCount;
+    if (DirtyCount > 0)
+    {
+        RunPathJobs(Graph, World, Scratch, Memory, DoPathRebuildJob, DirtyChunks, DirtyCount);
+    }
+}
+
+// Solves every request queued this tick, the results are ready when this returns
+internal void ProcessPathRequests(path_Graph* Graph, game_World* World, path_Scratch** Scratch, game_Memory* Memory)
+{
+    Graph->SolvedRequestCount = Graph->RequestCount;
+    if (Graph->RequestCount > 0)
+    {
+        RunPathJobs(Graph, World, Scratch, Memory, DoPathRequestJob, 0, Graph->RequestCount);
+    }
+
+    Graph->RequestCount = 0;
+}
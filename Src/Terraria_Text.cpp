@@ -0,0 +1,482 @@
+#include "../Include/Terraria_Text.h"
+
+#include <emmintrin.h>
+#include <stdio.h>
+#include <string.h>
+
+// The built in font, one byte per row of a glyph with the leftmost pixel in bit 4
+global_variable uint8 TextFontBits[TEXT_GLYPH_COUNT][TEXT_CELL_HEIGHT] =
+{
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // Space
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04, 0x00 },  // !
+    { 0x0A, 0x0A, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // "
+    { 0x0A, 0x0A, 0x1F, 0x0A, 0x1F, 0x0A, 0x0A, 0x00 },  // #
+    { 0x04, 0x0F, 0x14, 0x0E, 0x05, 0x1E, 0x04, 0x00 },  // $
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03, 0x00 },  // %
+    { 0x0C, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0D, 0x00 },  // &
+    { 0x04, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // '
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02, 0x00 },  // (
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08, 0x00 },  // )
+    { 0x00, 0x04, 0x15, 0x0E, 0x15, 0x04, 0x00, 0x00 },  // *
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00, 0x00 },  // +
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x04, 0x08 },  // ,
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00, 0x00 },  // -
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00 },  // .
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00, 0x00 },  // /
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E, 0x00 },  // 0
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00 },  // 1
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F, 0x00 },  // 2
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E, 0x00 },  // 3
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02, 0x00 },  // 4
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E, 0x00 },  // 5
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E, 0x00 },  // 6
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08, 0x00 },  // 7
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E, 0x00 },  // 8
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C, 0x00 },  // 9
+    { 0x00, 0x00, 0x04, 0x00, 0x00, 0x04, 0x00, 0x00 },  // :
+    { 0x00, 0x00, 0x04, 0x00, 0x00, 0x04, 0x04, 0x08 },  // ;
+    { 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02, 0x00 },  // <
+    { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00, 0x00 },  // =
+    { 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08, 0x00 },  // >
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04, 0x00 },  // ?
+    { 0x0E, 0x11, 0x01, 0x0D, 0x15, 0x15, 0x0E, 0x00 },  // @
+    { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11, 0x00 },  // A
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E, 0x00 },  // B
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E, 0x00 },  // C
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C, 0x00 },  // D
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F, 0x00 },  // E
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10, 0x00 },  // F
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F, 0x00 },  // G
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11, 0x00 },  // H
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00 },  // I
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C, 0x00 },  // J
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11, 0x00 },  // K
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F, 0x00 },  // L
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11, 0x00 },  // M
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x00 },  // N
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00 },  // O
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10, 0x00 },  // P
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D, 0x00 },  // Q
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11, 0x00 },  // R
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E, 0x00 },  // S
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00 },  // T
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E, 0x00 },  // U
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x00 },  // V
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A, 0x00 },  // W
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11, 0x00 },  // X
+    { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04, 0x00 },  // Y
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F, 0x00 },  // Z
+    { 0x0E, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0E, 0x00 },  // [
+    { 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00 },  // Backslash
+    { 0x0E, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0E, 0x00 },  // ]
+    { 0x04, 0x0A, 0x11, 0x00, 0x00, 0x00, 0x00, 0x00 },  // ^
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1F },  // _
+    { 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // `
+    { 0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F, 0x00 },  // a
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E, 0x00 },  // b
+    { 0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E, 0x00 },  // c
+    { 0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F, 0x00 },  // d
+    { 0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E, 0x00 },  // e
+    { 0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08, 0x00 },  // f
+    { 0x00, 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E },  // g
+    { 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00 },  // h
+    { 0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E, 0x00 },  // i
+    { 0x02, 0x00, 0x06, 0x02, 0x02, 0x02, 0x12, 0x0C },  // j
+    { 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12, 0x00 },  // k
+    { 0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E, 0x00 },  // l
+    { 0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11, 0x00 },  // m
+    { 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00 },  // n
+    { 0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E, 0x00 },  // o
+    { 0x00, 0x00, 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10 },  // p
+    { 0x00, 0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x01 },  // q
+    { 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10, 0x00 },  // r
+    { 0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E, 0x00 },  // s
+    { 0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06, 0x00 },  // t
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D, 0x00 },  // u
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04, 0x00 },  // v
+    { 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A, 0x00 },  // w
+    { 0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x00 },  // x
+    { 0x00, 0x00, 0x11, 0x11, 0x11, 0x0F, 0x01, 0x0E },  // y
+    { 0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F, 0x00 },  // z
+    { 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02, 0x00 },  // {
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x00 },  // |
+    { 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08, 0x00 },  // }
+    { 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00 },  // ~
+};
+
+inline bool32 IsFontPixelSet(int32 GlyphIndex, int32 X, int32 Y)
+{
+    return (TextFontBits[GlyphIndex][Y] >> (TEXT_CELL_WIDTH - 1 - X)) & 1;
+}
+
+// Rasterizes every glyph at every size into the atlas, packed in shelves with a pixel of padding around every glyph.
+// The drop shadow is baked in one font pixel down and to the right, so a glyph is a single quad whatever it is drawn over
+internal void InitializeText(text_State* Text, memory_Arena* Arena)
+{
+    Text->Atlas = PushArray(Arena, TEXT_ATLAS_WIDTH * TEXT_ATLAS_HEIGHT, uint8);
+    Text->Layouts = PushArray(Arena, TEXT_LAYOUT_CACHE_SIZE, text_Layout);
+    Text->Quads = PushArray(Arena, TEXT_BATCH_SIZE, text_Batch_Quad);
+    Text->FrameIndex = 0;
+    Text->QuadCount = 0;
+
+    memset(Text->Atlas, 0, TEXT_ATLAS_WIDTH * TEXT_ATLAS_HEIGHT);
+    memset(Text->Layouts, 0, TEXT_LAYOUT_CACHE_SIZE * sizeof(text_Layout));
+
+    int32 PackX = 1;
+    int32 PackY = 1;
+    int32 ShelfHeight = 0;
+
+    // Biggest first so the tall glyphs share shelves
+    for (int32 Size = TextSize_Count - 1; Size >= 0; --Size)
+    {
+        text_Font* Font = &Text->Fonts[Size];
+        Font->Scale = Size + 1;
+        Font->LineHeight = (TEXT_CELL_HEIGHT + 1) * Font->Scale;
+
+        for (int32 GlyphIndex = 0; GlyphIndex < TEXT_GLYPH_COUNT; ++GlyphIndex)
+        {
+            text_Glyph* Glyph = &Font->Glyphs[GlyphIndex];
+
+            int32 MinX = TEXT_CELL_WIDTH;
+            int32 MinY = TEXT_CELL_HEIGHT;
+            int32 MaxX = -1;
+            int32 MaxY = -1;
+            for (int32 Y = 0; Y < TEXT_CELL_HEIGHT; ++Y)
+            {
+                for (int32 X = 0; X < TEXT_CELL_WIDTH; ++X)
+                {
+                    if (IsFontPixelSet(GlyphIndex, X, Y))
+                    {
+                        if (X < MinX) { MinX = X; }
+                        if (X > MaxX) { MaxX = X; }
+                        if (Y < MinY) { MinY = Y; }
+                        if (Y > MaxY) { MaxY = Y; }
+                    }
+                }
+            }
+
+            // Glyphs are packed by their ink only, the space has none and just advances
+            if (MaxX < 0)
+            {
+                *Glyph = {};
+                Glyph->Advance = (uint8)(3 * Font->Scale);
+                continue;
+            }
+
+            int32 InkWidth = (MaxX - MinX + 1) * Font->Scale;
+            int32 Width = InkWidth + Font->Scale;
+            int32 Height = (MaxY - MinY + 1) * Font->Scale + Font->Scale;
+            if ((PackX + Width + 1) > TEXT_ATLAS_WIDTH)
+            {
+                PackX = 1;
+                PackY += ShelfHeight + 1;
+                ShelfHeight = 0;
+            }
+            Assert((PackY + Height + 1) <= TEXT_ATLAS_HEIGHT);
+
+            for (int32 Y = 0; Y < Height; ++Y)
+            {
+                uint8* Texel = Text->Atlas + (PackY + Y) * TEXT_ATLAS_WIDTH + PackX;
+                for (int32 X = 0; X < Width; ++X)
+                {
+                    int32 FontX = X / Font->Scale;
+                    int32 FontY = Y / Font->Scale;
+                    if ((FontX <= MaxX - MinX) && (FontY <= MaxY - MinY) && IsFontPixelSet(GlyphIndex, MinX + FontX, MinY + FontY))
+                    {
+                        *Texel = TEXT_TEXEL_FILL;
+                    }
+                    else if ((FontX > 0) && (FontY > 0) && IsFontPixelSet(GlyphIndex, MinX + FontX - 1, MinY + FontY - 1))
+                    {
+                        *Texel = TEXT_TEXEL_SHADOW;
+                    }
+                    ++Texel;
+                }
+            }
+
+            Glyph->AtlasX = (uint16)PackX;
+            Glyph->AtlasY = (uint16)PackY;
+            Glyph->Width = (uint8)Width;
+            Glyph->Height = (uint8)Height;
+            Glyph->OffsetX = 0;
+            Glyph->OffsetY = (uint8)(MinY * Font->Scale);
+            Glyph->Advance = (uint8)(InkWidth + Font->Scale);
+
+            PackX += Width + 1;
+            if (Height > ShelfHeight)
+            {
+                ShelfHeight = Height;
+            }
+        }
+    }
+}
+
+internal void BeginText(text_State* Text)
+{
+    ++Text->FrameIndex;
+    Text->QuadCount = 0;
+    Text->LayoutHitCount = 0;
+    Text->LayoutMissCount = 0;
+}
+
+// FNV-1a over the characters, with the size folded in so every size gets its own entry
+internal uint64 HashText(int32 Size, char* String, int32 Length)
+{
+    uint64 Hash = 14695981039346656037ULL ^ (uint64)Size;
+    for (int32 Index = 0; Index < Length; ++Index)
+    {
+        Hash = (Hash ^ (uint8)String[Index]) * 1099511628211ULL;
+    }
+
+    return Hash;
+}
+
+internal void LayoutText(text_State* Text, text_Layout* Layout)
+{
+    text_Font* Font = &Text->Fonts[Layout->Size];
+
+    int32 PenX = 0;
+    int32 PenY = 0;
+    Layout->Width = 0;
+    Layout->Height = Font->LineHeight;
+    Layout->QuadCount = 0;
+
+    for (int32 Index = 0; Index < Layout->Length; ++Index)
+    {
+        char Character = Layout->Text[Index];
+        if (Character == '\n')
+        {
+            PenX = 0;
+            PenY += Font->LineHeight;
+            Layout->Height += Font->LineHeight;
+            continue;
+        }
+
+        // Anything the font does not have shows up as a question mark
+        if ((Character < TEXT_FIRST_CHARACTER) || (Character > TEXT_LAST_CHARACTER))
+        {
+            Character = '?';
+        }
+
+        text_Glyph* Glyph = &Font->Glyphs[Character - TEXT_FIRST_CHARACTER];
+        if (Glyph->Width)
+        {
+            text_Quad* Quad = &Layout->Quads[Layout->QuadCount++];
+            Quad->X = (int16)(PenX + Glyph->OffsetX);
+            Quad->Y = (int16)(PenY + Glyph->OffsetY);
+            Quad->AtlasX = Glyph->AtlasX;
+            Quad->AtlasY = Glyph->AtlasY;
+            Quad->Width = Glyph->Width;
+            Quad->Height = Glyph->Height;
+        }
+
+        PenX += Glyph->Advance;
+        if (PenX - Font->Scale > Layout->Width)
+        {
+            Layout->Width = PenX - Font->Scale;
+        }
+    }
+}
+
+// Returns the cached layout of the string, laying it out only when it is not in the cache.
+// A miss takes over the least recently used entry of the few the hash can land in, strings past TEXT_MAX_LAYOUT_LENGTH are cut off
+internal text_Layout* GetTextLayout(text_State* Text, int32 Size, char* String)
+{
+    int32 Length = 0;
+    while (String[Length] && (Length < TEXT_MAX_LAYOUT_LENGTH))
+    {
+        ++Length;
+    }
+
+    uint64 Hash = HashText(Size, String, Length);
+    uint32 FirstIndex = (uint32)Hash & (TEXT_LAYOUT_CACHE_SIZE - 1);
+
+    text_Layout* Result = 0;
+    text_Layout* LeastRecentlyUsed = 0;
+    for (uint32 Probe = 0; Probe < TEXT_LAYOUT_PROBE_COUNT; ++Probe)
+    {
+        text_Layout* Layout = &Text->Layouts[(FirstIndex + Probe) & (TEXT_LAYOUT_CACHE_SIZE - 1)];
+        if ((Layout->Hash == Hash) && (Layout->Size == Size) && (Layout->Length == Length) &&
+            (memcmp(Layout->Text, String, Length) == 0))
+        {
+            Result = Layout;
+            break;
+        }
+
+        if (!LeastRecentlyUsed || (Layout->LastUsedFrame < LeastRecentlyUsed->LastUsedFrame))
+        {
+            LeastRecentlyUsed = Layout;
+        }
+    }
+
+    if (Result)
+    {
+        ++Text->LayoutHitCount;
+    }
+    else
+    {
+        ++Text->LayoutMissCount;
+
+        Result = LeastRecentlyUsed;
+        Result->Hash = Hash;
+        Result->Size = Size;
+        Result->Length = Length;
+        memcpy(Result->Text, String, Length);
+        LayoutText(Text, Result);
+    }
+
+    Result->LastUsedFrame = Text->FrameIndex;
+    return Result;
+}
+
+// Queues the glyphs of a layout at a screen position, the batch keeps its own copy so the layout can be evicted right after
+internal void PushTextLayout(text_State* Text, text_Layout* Layout, int32 X, int32 Y, uint32 Color)
+{
+    for (int32 QuadIndex = 0; (QuadIndex < Layout->QuadCount) && (Text->QuadCount < TEXT_BATCH_SIZE); ++QuadIndex)
+    {
+        text_Quad* Quad = &Layout->Quads[QuadIndex];
+        text_Batch_Quad* BatchQuad = &Text->Quads[Text->QuadCount++];
+        BatchQuad->X = (int16)(X + Quad->X);
+        BatchQuad->Y = (int16)(Y + Quad->Y);
+        BatchQuad->AtlasX = Quad->AtlasX;
+        BatchQuad->AtlasY = Quad->AtlasY;
+        BatchQuad->Width = Quad->Width;
+        BatchQuad->Height = Quad->Height;
+        BatchQuad->Color = Color;
+    }
+}
+
+internal void DrawTextLayout(text_State* Text, text_Layout* Layout, int32 X, int32 Y, uint32 Color)
+{
+    // Clipping to the 16 bit batch coordinates, anything that far out is off screen anyway
+    if ((X > -16384) && (X < 16384) && (Y > -16384) && (Y < 16384))
+    {
+        PushTextLayout(Text, Layout, X, Y, Color);
+    }
+}
+
+internal void DrawString(text_State* Text, int32 Size, int32 X, int32 Y, uint32 Color, char* String)
+{
+    DrawTextLayout(Text, GetTextLayout(Text, Size, String), X, Y, Color);
+}
+
+// Blits every queued glyph in the order it was drawn.
+// Texels are masks (fill, shadow or nothing), so four pixels at a time are picked between the color, the shadow and what is there
+internal void FlushText(game_Offscreen_Buffer* Buffer, text_State* Text)
+{
+    __m128i FillTexel_4x = _mm_set1_epi32((int)0xFFFFFFFF);
+    __m128i ShadowTexel_4x = _mm_set1_epi32(TEXT_TEXEL_SHADOW * 0x01010101);
+    __m128i ShadowColor_4x = _mm_set1_epi32(TEXT_SHADOW_COLOR);
+
+    for (int32 QuadIndex = 0; QuadIndex < Text->QuadCount; ++QuadIndex)
+    {
+        text_Batch_Quad* Quad = &Text->Quads[QuadIndex];
+
+        int32 MinX = Quad->X;
+        int32 MinY = Quad->Y;
+        int32 MaxX = Quad->X + Quad->Width;
+        int32 MaxY = Quad->Y + Quad->Height;
+        if (MinX < 0) { MinX = 0; }
+        if (MinY < 0) { MinY = 0; }
+        if (MaxX > Buffer->Width) { MaxX = Buffer->Width; }
+        if (MaxY > Buffer->Height) { MaxY = Buffer->Height; }
+
+        uint32 Color = Quad->Color;
+        __m128i Color_4x = _mm_set1_epi32((int)Color);
+
+        uint8* SourceRow = Text->Atlas + (Quad->AtlasY + (MinY - Quad->Y)) * TEXT_ATLAS_WIDTH + Quad->AtlasX + (MinX - Quad->X);
+        uint8* DestRow = (uint8*)Buffer->Memory + MinY * Buffer->Pitch + MinX * 4;
+        for (int32 Y = MinY; Y < MaxY; ++Y)
+        {
+            uint8* Texel = SourceRow;
+            uint32* Pixel = (uint32*)DestRow;
+
+            int32 X = MinX;
+            for (; (X + 4) <= MaxX; X += 4)
+            {
+                // Spread every texel over the four bytes of its pixel
+                int32 Texels;
+                memcpy(&Texels, Texel, sizeof(Texels));
+                __m128i Texel_4x = _mm_cvtsi32_si128(Texels);
+                Texel_4x = _mm_unpacklo_epi8(Texel_4x, Texel_4x);
+                Texel_4x = _mm_unpacklo_epi16(Texel_4x, Texel_4x);
+
+                __m128i FillMask = _mm_cmpeq_epi32(Texel_4x, FillTexel_4x);
+                __m128i ShadowMask = _mm_cmpeq_epi32(Texel_4x, ShadowTexel_4x);
+                __m128i KeepMask = _mm_andnot_si128(_mm_or_si128(FillMask, ShadowMask), FillTexel_4x);
+
+                __m128i Dest = _mm_loadu_si128((__m128i*)Pixel);
+                Dest = _mm_or_si128(_mm_or_si128(_mm_and_si128(FillMask, Color_4x), _mm_and_si128(ShadowMask, ShadowColor_4x)),
+                                    _mm_and_si128(KeepMask, Dest));
+                _mm_storeu_si128((__m128i*)Pixel, Dest);
+
+                Texel += 4;
+                Pixel += 4;
+            }
+
+            // The last few pixels one at a time, a wider load would read the next glyph in the atlas
+            for (; X < MaxX; ++X)
+            {
+                if (*Texel == TEXT_TEXEL_FILL)        { *Pixel = Color; }
+                else if (*Texel == TEXT_TEXEL_SHADOW) { *Pixel = TEXT_SHADOW_COLOR; }
+                ++Texel;
+                ++Pixel;
+            }
+
+            SourceRow += TEXT_ATLAS_WIDTH;
+            DestRow += Buffer->Pitch;
+        }
+    }
+}
+
+// Nothing in the game deals damage yet, so only the benchmark workload spawns numbers. The update and the drawing always run
+#if TERRARIA_BENCHMARK
+internal void SpawnFloatingNumber(floating_Number_List* List, real32 X, real32 Y, int32 Value, uint32 Color)
+{
+    if (List->Count < FLOATING_NUMBER_COUNT)
+    {
+        floating_Number* Number = &List->Numbers[List->Count++];
+        Number->X = X;
+        Number->Y = Y;
+        Number->VelocityY = -90.0f;
+        Number->Life = 1.2f;
+        Number->Color = Color;
+
+        // Formatted once here, drawing it every frame after that is a layout cache hit
+        snprintf(Number->Text, sizeof(Number->Text), "%d", Value);
+    }
+}
+#endif
+
+internal void UpdateFloatingNumbers(floating_Number_List* List, real32 dt)
+{
+    for (int32 Index = 0; Index < List->Count;)
+    {
+        floating_Number* Number = &List->Numbers[Index];
+        Number->Y += Number->VelocityY * dt;
+        Number->VelocityY *= 0.95f;
+        Number->Life -= dt;
+
+        if (Number->Life <= 0.0f)
+        {
+            *Number = List->Numbers[--List->Count];
+        }
+        else
+        {
+            ++Index;
+        }
+    }
+}
+
+internal void DrawFloatingNumbers(text_State* Text, floating_Number_List* List, int32 CameraX, int32 CameraY)
+{
+    for (int32 Index = 0; Index < List->Count; ++Index)
+    {
+        floating_Number* Number = &List->Numbers[Index];
+
+        // Centered on where the hit was, the size comes from the cached layout
+        text_Layout* Layout = GetTextLayout(Text, TextSize_Medium, Number->Text);
+        int32 X = (int32)Number->X - CameraX - Layout->Width / 2;
+        int32 Y = (int32)Number->Y - CameraY - Layout->Height / 2;
+        DrawTextLayout(Text, Layout, X, Y, Number->Color);
+    }
+}
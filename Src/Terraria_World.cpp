@@ -0,0 +1,178 @@
+#include "../Include/Terraria_World.h"
+
+internal void SetTileRaw(game_World* World, int32 TileX, int32 TileY, uint8 Tile)
+{
+    if (IsTileInWorld(TileX, TileY))
+    {
+        world_Chunk* Chunk = &World->Chunks[GetChunkIndex(TileX >> WORLD_CHUNK_SHIFT, TileY >> WORLD_CHUNK_SHIFT)];
+        Chunk->Tiles[((TileY & WORLD_CHUNK_MASK) << WORLD_CHUNK_SHIFT) | (TileX & WORLD_CHUNK_MASK)] = Tile;
+    }
+}
+
+// Carves a filled circle of air, used by the cave worms
+internal void CarveCircle(game_World* World, int32 CenterX, int32 CenterY, int32 Radius)
+{
+    for (int32 y = -Radius; y <= Radius; ++y)
+    {
+        for (int32 x = -Radius; x <= Radius; ++x)
+        {
+            if ((x * x + y * y) <= (Radius * Radius))
+            {
+                SetTileRaw(World, CenterX + x, CenterY + y, Tile_Air);
+            }
+        }
+    }
+}
+
+internal int32 GetSurfaceHeight(int32 TileX)
+{
+    // A few stacked sine waves are enough for rolling hills
+    real32 x = (real32)TileX;
+    real32 Height = (real32)(WORLD_TILE_COUNT_Y / 4);
+    Height += 12.0f * sinf(x * 0.013f);
+    Height += 5.0f * sinf(x * 0.051f + 1.3f);
+    Height += 2.0f * sinf(x * 0.147f + 0.7f);
+
+    return (int32)Height;
+}
+
+internal void GenerateWorld(game_World* World, random_Series* Series)
+{
+    // Fill every column with grass, dirt and stone below the surface and air above it
+    for (int32 TileX = 0; TileX < WORLD_TILE_COUNT_X; ++TileX)
+    {
+        int32 Surface = GetSurfaceHeight(TileX);
+        int32 DirtDepth = 8 + (int32)(4.0f * sinf((real32)TileX * 0.07f));
+
+        for (int32 TileY = 0; TileY < WORLD_TILE_COUNT_Y; ++TileY)
+        {
+            uint8 Tile = Tile_Air;
+            if (TileY == Surface)                     { Tile = Tile_Grass; }
+            else if (TileY > Surface + DirtDepth)     { Tile = Tile_Stone; }
+            else if (TileY > Surface)                 { Tile = Tile_Dirt; }
+
+            SetTileRaw(World, TileX, TileY, Tile);
+        }
+    }
+
+    // Caves are dug by "worms" that wander around underground and carve as they go
+    int32 WormCount = (WORLD_TILE_COUNT_X * WORLD_TILE_COUNT_Y) / 8192;
+    for (int32 WormIndex = 0; WormIndex < WormCount; ++WormIndex)
+    {
+        real32 x = (real32)RandomBetween(Series, 0, WORLD_TILE_COUNT_X - 1);
+        real32 y = (real32)RandomBetween(Series, WORLD_TILE_COUNT_Y / 4 + 20, WORLD_TILE_COUNT_Y - 8);
+        real32 Angle = (real32)RandomBetween(Series, 0, 628) * 0.01f;
+
+        int32 Length = RandomBetween(Series, 40, 160);
+        for (int32 Step = 0; Step < Length; ++Step)
+        {
+            CarveCircle(World, (int32)x, (int32)y, RandomBetween(Series, 1, 3));
+
+            Angle += (real32)RandomBetween(Series, -40, 40) * 0.01f;
+            x += cosf(Angle);
+            y += sinf(Angle) * 0.6f;
+        }
+    }
+}
+
+internal void QueueTileEdit(tile_Edit_Queue* Queue, int32 TileX, int32 TileY, uint8 Tile)
+{
+    // Edits outside of the world (or past a full queue) are dropped instead of growing anything
+    if (IsTileInWorld(TileX, TileY) && (Queue->EditCount < TILE_EDIT_QUEUE_SIZE))
+    {
+        tile_Edit* Edit = &Queue->Edits[Queue->EditCount++];
+        Edit->TileX = (uint16)TileX;
+        Edit->TileY = (uint16)TileY;
+        Edit->Tile = Tile;
+    }
+}
+
+// Explosions and other bulk edits, queues every tile of a filled circle
+internal void QueueTileCircle(tile_Edit_Queue* Queue, int32 CenterX, int32 CenterY, int32 Radius, uint8 Tile)
+{
+    for (int32 y = -Radius; y <= Radius; ++y)
+    {
+        for (int32 x = -Radius; x <= Radius; ++x)
+        {
+            if ((x * x + y * y) <= (Radius * Radius))
+            {
+                QueueTileEdit(Queue, CenterX + x, CenterY + y, Tile);
+            }
+        }
+    }
+}
+
+// Applies every queued edit in order and flags each chunk that really changed, exactly once no matter how many edits hit it,
+// plus the border of the chunk the edit was on if it was on one. Edits that write the tile that is already there do not dirty anything
+internal void ApplyTileEdits(game_World* World, tile_Edit_Queue* Queue, world_Dirty_Mask* DirtyMask, world_Border_Masks* BorderMasks)
+{
+    for (int32 EditIndex = 0; EditIndex < Queue->EditCount; ++EditIndex)
+    {
+        tile_Edit* Edit = &Queue->Edits[EditIndex];
+        int32 ChunkIndex = GetChunkIndex(Edit->TileX >> WORLD_CHUNK_SHIFT, Edit->TileY >> WORLD_CHUNK_SHIFT);
+        uint8* Tile = &World->Chunks[ChunkIndex].Tiles[((Edit->TileY & WORLD_CHUNK_MASK) << WORLD_CHUNK_SHIFT) | (Edit->TileX & WORLD_CHUNK_MASK)];
+
+        if (*Tile != Edit->Tile)
+        {
+            *Tile = Edit->Tile;
+            MarkChunkDirty(DirtyMask, ChunkIndex);
+
+            int32 LocalX = Edit->TileX & WORLD_CHUNK_MASK;
+            int32 LocalY = Edit->TileY & WORLD_CHUNK_MASK;
+            if (LocalX == 0)                { MarkChunkDirty(&BorderMasks->Sides[WorldBorder_West], ChunkIndex); }
+            if (LocalX == WORLD_CHUNK_MASK) { MarkChunkDirty(&BorderMasks->Sides[WorldBorder_East], ChunkIndex); }
+            if (LocalY == 0)                { MarkChunkDirty(&BorderMasks->Sides[WorldBorder_North], ChunkIndex); }
+            if (LocalY == WORLD_CHUNK_MASK) { MarkChunkDirty(&BorderMasks->Sides[WorldBorder_South], ChunkIndex); }
+        }
+    }
+
+    int32 ChangedChunkCount = 0;
+    for (int32 WordIndex = 0; WordIndex < WORLD_DIRTY_MASK_WORD_COUNT; ++WordIndex)
+    {
+        for (uint64 Word = DirtyMask->Words[WordIndex]; Word; Word &= Word - 1)
+        {
+            ++ChangedChunkCount;
+        }
+    }
+
+    Queue->AppliedEditCount = Queue->EditCount;
+    Queue->ChangedChunkCount = ChangedChunkCount;
+    Queue->EditCount = 0;
+}
+
+internal void MarkAllChunksDirty(world_Dirty_Mask* DirtyMask)
+{
+    for (int32 ChunkIndex = 0; ChunkIndex < WORLD_CHUNK_COUNT; ++ChunkIndex)
+    {
+        MarkChunkDirty(DirtyMask, ChunkIndex);
+    }
+}
+
+internal void ClearDirtyMask(world_Dirty_Mask* DirtyMask)
+{
+    for (int32 WordIndex = 0; WordIndex < WORLD_DIRTY_MASK_WORD_COUNT; ++WordIndex)
+    {
+        DirtyMask->Words[WordIndex] = 0;
+    }
+}
+
+// Recounts the solid tiles of every dirty chunk
+internal void UpdateWorldRenderCache(world_Render_Cache* Cache, game_World* World, world_Dirty_Mask* DirtyMask)
+{
+    for (int32 WordIndex = 0; WordIndex < WORLD_DIRTY_MASK_WORD_COUNT; ++WordIndex)
+    {
+        for (uint64 Word = DirtyMask->Words[WordIndex]; Word; Word &= Word - 1)
+        {
+            int32 ChunkIndex = WordIndex * 64 + FindLowestSetBit(Word);
+            uint8* Tiles = World->Chunks[ChunkIndex].Tiles;
+
+            uint16 SolidTileCount = 0;
+            for (int32 TileIndex = 0; TileIndex < WORLD_CHUNK_TILE_COUNT; ++TileIndex)
+            {
+                SolidTileCount += (Tiles[TileIndex] != Tile_Air);
+            }
+
+            Cache->SolidTileCount[ChunkIndex] = SolidTileCount;
+        }
+    }
+}
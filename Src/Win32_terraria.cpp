@@ -17,31 +17,7 @@
 
                                                          --------------------------------------------------*/
 
-// PUT THIS HERE TO STOP THE COMPILER FROM BITCHING
-#include <stdint.h>
-#include <math.h>
-
-// Macros to differentiate between all the statics
-#define internal static;
-#define local_persist static;
-#define global_variable static;
-constexpr auto PI32 = 3.14159265359f;
-
-// typedef to ease using some of the other types of ints and uints
-typedef int8_t int8;
-typedef int16_t int16;
-typedef int32_t int32;
-typedef int64_t int64;
-
-typedef uint8_t uint8;
-typedef uint16_t uint16;
-typedef uint32_t uint32;
-typedef uint64_t uint64;
-
-typedef int32_t bool32;
-
-typedef float real32;
-typedef double real64;
+#include "../Include/Terraria_Platform.h"
 
 // Game header files
 #include "Terraria.cpp"
@@ -51,6 +27,7 @@ typedef double real64;
 #include <xinput.h>
 #include <dsound.h>
 #include <malloc.h>
+#include <stdio.h>
 
 // Structure that contains data about the buffer
 struct Win32_Offscreen_Buffer
@@ -102,6 +79,7 @@ global_variable X_InputSetState* XInputSetState_ = XInputSetStateStub;
 global_variable bool32 running;
 global_variable Win32_Offscreen_Buffer globalBackBuffer;
 global_variable LPDIRECTSOUNDBUFFER SecondaryAudioBuffer;
+global_variable bool32 RewindRequested;
 
 // Static function to load the xinput library
 internal void Win32_LoadXInput(void)
@@ -248,6 +226,564 @@ struct Win32_Sound_Output
     real32 tSine;
 };
 
+struct platform_Work_Queue_Entry
+{
+    platform_Work_Queue_Callback* Callback;
+    void* Data;
+};
+
+// Single producer (the game thread), multiple consumers (the worker threads and the game thread while it waits)
+struct platform_Work_Queue
+{
+    uint32 volatile CompletionGoal;
+    uint32 volatile CompletionCount;
+
+    uint32 volatile NextEntryToWrite;
+    uint32 volatile NextEntryToRead;
+    HANDLE SemaphoreHandle;
+
+    platform_Work_Queue_Entry Entries[256];
+};
+
+internal void Win32_AddEntry(platform_Work_Queue* Queue, platform_Work_Queue_Callback* Callback, void* Data)
+{
+    uint32 NewNextEntryToWrite = (Queue->NextEntryToWrite + 1) % ArrayCount(Queue->Entries);
+    Assert(NewNextEntryToWrite != Queue->NextEntryToRead);
+
+    platform_Work_Queue_Entry* Entry = Queue->Entries + Queue->NextEntryToWrite;
+    Entry->Callback = Callback;
+    Entry->Data = Data;
+    ++Queue->CompletionGoal;
+
+    // Make sure the entry is written before the workers can see it
+    _WriteBarrier();
+    Queue->NextEntryToWrite = NewNextEntryToWrite;
+    ReleaseSemaphore(Queue->SemaphoreHandle, 1, 0);
+}
+
+// Returns true when there was nothing left to do
+internal bool32 Win32_DoNextWorkQueueEntry(platform_Work_Queue* Queue)
+{
+    bool32 WeShouldSleep = false;
+
+    uint32 OriginalNextEntryToRead = Queue->NextEntryToRead;
+    uint32 NewNextEntryToRead = (OriginalNextEntryToRead + 1) % ArrayCount(Queue->Entries);
+    if (OriginalNextEntryToRead != Queue->NextEntryToWrite)
+    {
+        // Only the thread that wins the exchange gets to run the entry
+        uint32 Index = InterlockedCompareExchange((LONG volatile*)&Queue->NextEntryToRead, NewNextEntryToRead, OriginalNextEntryToRead);
+        if (Index == OriginalNextEntryToRead)
+        {
+            platform_Work_Queue_Entry Entry = Queue->Entries[Index];
+            Entry.Callback(Queue, Entry.Data);
+            InterlockedIncrement((LONG volatile*)&Queue->CompletionCount);
+        }
+    }
+    else
+    {
+        WeShouldSleep = true;
+    }
+
+    return WeShouldSleep;
+}
+
+internal void Win32_CompleteAllWork(platform_Work_Queue* Queue)
+{
+    // Help out instead of just waiting
+    while (Queue->CompletionGoal != Queue->CompletionCount)
+    {
+        Win32_DoNextWorkQueueEntry(Queue);
+    }
+
+    Queue->CompletionGoal = 0;
+    Queue->CompletionCount = 0;
+}
+
+internal DWORD WINAPI Win32_WorkerThreadProc(LPVOID lpParameter)
+{
+    platform_Work_Queue* Queue = (platform_Work_Queue*)lpParameter;
+    for (;;)
+    {
+        if (Win32_DoNextWorkQueueEntry(Queue))
+        {
+            WaitForSingleObjectEx(Queue->SemaphoreHandle, INFINITE, FALSE);
+        }
+    }
+}
+
+internal void Win32_MakeQueue(platform_Work_Queue* Queue, uint32 ThreadCount)
+{
+    Queue->CompletionGoal = 0;
+    Queue->CompletionCount = 0;
+    Queue->NextEntryToWrite = 0;
+    Queue->NextEntryToRead = 0;
+
+    Queue->SemaphoreHandle = CreateSemaphoreExA(0, 0, ThreadCount, 0, 0, SEMAPHORE_ALL_ACCESS);
+    for (uint32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        DWORD ThreadID;
+        HANDLE ThreadHandle = CreateThread(0, 0, Win32_WorkerThreadProc, Queue, 0, &ThreadID);
+        CloseHandle(ThreadHandle);
+    }
+}
+
+// Prints what the game's timed blocks measured this frame and resets them for the next one
+internal void Win32_HandleDebugCycleCounters(game_Memory* Memory)
+{
+#if TERRARIA_BENCHMARK
+    OutputDebugStringA("DEBUG CYCLE COUNTS:\n");
+    for (uint32 CounterIndex = 0; CounterIndex < ArrayCount(Memory->Counters); ++CounterIndex)
+    {
+        debug_Cycle_Counter* Counter = Memory->Counters + CounterIndex;
+        if (Counter->HitCount)
+        {
+            char TextBuffer[256];
+            _snprintf_s(TextBuffer, sizeof(TextBuffer),
+                        "  %u: %I64ucy %uh %I64ucy/h\n",
+                        CounterIndex,
+                        Counter->CycleCount,
+                        Counter->HitCount,
+                        Counter->CycleCount / Counter->HitCount);
+            OutputDebugStringA(TextBuffer);
+
+            if (CounterIndex == DebugCycleCounter_EncodeSnapshots)
+            {
+                for (uint32 ClientIndex = 0; ClientIndex < ArrayCount(Memory->NetCounters); ++ClientIndex)
+                {
+                    debug_Net_Counter* NetCounter = Memory->NetCounters + ClientIndex;
+                    if (NetCounter->TickCount)
+                    {
+                        _snprintf_s(TextBuffer, sizeof(TextBuffer),
+                                    "    client %u: %ub/tick %u chunks\n",
+                                    ClientIndex,
+                                    NetCounter->BytesSent / NetCounter->TickCount,
+                                    NetCounter->ChunksSent);
+                        OutputDebugStringA(TextBuffer);
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    for (uint32 CounterIndex = 0; CounterIndex < ArrayCount(Memory->Counters); ++CounterIndex)
+    {
+        Memory->Counters[CounterIndex].CycleCount = 0;
+        Memory->Counters[CounterIndex].HitCount = 0;
+    }
+
+    for (uint32 ClientIndex = 0; ClientIndex < ArrayCount(Memory->NetCounters); ++ClientIndex)
+    {
+        debug_Net_Counter EmptyCounter = {};
+        Memory->NetCounters[ClientIndex] = EmptyCounter;
+    }
+}
+
+// Save and rewind points of the permanent storage.
+// The storage is allocated with MEM_WRITE_WATCH so Windows tells us which pages were written since the last point,
+// a point only costs the pages that changed:
+// - The shadow is a copy of the permanent storage as it was at the latest point
+// - Every point keeps the old contents of the pages it changed (an undo delta) in a ring, the oldest ones are dropped when it is full
+// - The first point is taken right after the game initialized and keeps no delta, so no rewind can go back to before that
+// - The autosave file is a header followed by a full image of the storage, only the changed pages are written into it.
+//   The header is marked as not committed while a point is being written, so an image torn by a crash is never resumed.
+//   The file is flushed after the header is cleared and again before it is set, on a thread of its own so the frame does not wait
+//   for the disk, which keeps that true when the whole machine goes down as well
+#define WIN32_SNAPSHOT_INTERVAL GAME_UPDATE_HZ
+#define WIN32_SNAPSHOT_COUNT 32
+
+#define WIN32_AUTOSAVE_FILE_NAME "terraria_autosave.dat"
+#define WIN32_AUTOSAVE_MAGIC 0x56415354 // "TSAV"
+// The image starts a page in, so the pages of the storage stay aligned in the file
+#define WIN32_AUTOSAVE_HEADER_SIZE 4096
+
+struct Win32_Autosave_Header
+{
+    uint32 Magic;
+    uint32 Committed;
+    uint64 StorageSize;
+
+    // The memory layout changes with every build, so an image is only resumed by the build that wrote it
+    uint32 BuildId;
+};
+
+static_assert(sizeof(Win32_Autosave_Header) <= WIN32_AUTOSAVE_HEADER_SIZE, "The autosave header does not fit in front of the image");
+
+struct Win32_Autosave_Run
+{
+    size_t Offset;
+    size_t Size;
+};
+
+struct Win32_Snapshot_Delta
+{
+    size_t Offset;   // Where the delta starts in the pool
+    size_t Size;
+    uint32 PageCount;
+};
+
+struct Win32_Snapshot_State
+{
+    uint8* Memory;
+    size_t MemorySize;
+    uint8* Shadow;
+    size_t PageSize;
+
+    // Until the first point the shadow is the storage before the game initialized it, which is not a state to go back to
+    bool32 ShadowIsInitialized;
+
+    // Scratch for GetWriteWatch, big enough for every page of the storage
+    ULONG_PTR DirtyPageCapacity;
+    void** DirtyPages;
+
+    uint8* DeltaPool;
+    size_t DeltaPoolSize;
+    size_t DeltaPoolNext;
+
+    // Oldest first
+    uint32 FirstDelta;
+    uint32 DeltaCount;
+    Win32_Snapshot_Delta Deltas[WIN32_SNAPSHOT_COUNT];
+
+    HANDLE AutosaveFile;
+    uint32 BuildId;
+    int32 FramesSinceSnapshot;
+
+    // What the writer thread puts into the autosave file, runs of neighboring pages of the shadow.
+    // The shadow and the runs belong to the writer from AutosaveStart until AutosaveDone
+    HANDLE AutosaveThread;
+    HANDLE AutosaveStart;
+    HANDLE AutosaveDone;
+    uint32 AutosaveRunCount;
+    Win32_Autosave_Run* AutosaveRuns;
+};
+
+// Every delta is the page indices followed by the pages themselves
+inline uint32* Win32_GetDeltaPageIndices(Win32_Snapshot_State* State, Win32_Snapshot_Delta* Delta)
+{
+    return (uint32*)(State->DeltaPool + Delta->Offset);
+}
+
+inline uint8* Win32_GetDeltaPages(Win32_Snapshot_State* State, Win32_Snapshot_Delta* Delta)
+{
+    return State->DeltaPool + Delta->Offset + ((Delta->PageCount * sizeof(uint32) + 15) & ~15);
+}
+
+// Returns the number of pages written since the last reset, and resets the tracking
+internal uint32 Win32_GetDirtyPages(Win32_Snapshot_State* State)
+{
+    ULONG_PTR Count = State->DirtyPageCapacity;
+    DWORD Granularity;
+    if (GetWriteWatch(WRITE_WATCH_FLAG_RESET, State->Memory, State->MemorySize, State->DirtyPages, &Count, &Granularity) != 0)
+    {
+        Count = 0;
+    }
+
+    return (uint32)Count;
+}
+
+internal void Win32_WriteAutosaveHeader(Win32_Snapshot_State* State, bool32 Committed)
+{
+    Win32_Autosave_Header Header = {};
+    Header.Magic = WIN32_AUTOSAVE_MAGIC;
+    Header.Committed = Committed;
+    Header.StorageSize = State->MemorySize;
+    Header.BuildId = State->BuildId;
+
+    LARGE_INTEGER Zero = {};
+    DWORD BytesWritten;
+    SetFilePointerEx(State->AutosaveFile, Zero, 0, FILE_BEGIN);
+    WriteFile(State->AutosaveFile, &Header, sizeof(Header), &BytesWritten, 0);
+}
+
+internal void Win32_WriteAutosave(Win32_Snapshot_State* State)
+{
+    Win32_WriteAutosaveHeader(State, false);
+    FlushFileBuffers(State->AutosaveFile);
+
+    for (uint32 RunIndex = 0; RunIndex < State->AutosaveRunCount; ++RunIndex)
+    {
+        Win32_Autosave_Run* Run = &State->AutosaveRuns[RunIndex];
+        LARGE_INTEGER FileOffset;
+        FileOffset.QuadPart = (LONGLONG)(WIN32_AUTOSAVE_HEADER_SIZE + Run->Offset);
+        DWORD BytesWritten;
+        SetFilePointerEx(State->AutosaveFile, FileOffset, 0, FILE_BEGIN);
+        WriteFile(State->AutosaveFile, State->Shadow + Run->Offset, (DWORD)Run->Size, &BytesWritten, 0);
+    }
+
+    FlushFileBuffers(State->AutosaveFile);
+    Win32_WriteAutosaveHeader(State, true);
+}
+
+internal DWORD WINAPI Win32_AutosaveThreadProc(LPVOID lpParameter)
+{
+    Win32_Snapshot_State* State = (Win32_Snapshot_State*)lpParameter;
+    for (;;)
+    {
+        WaitForSingleObjectEx(State->AutosaveStart, INFINITE, FALSE);
+        Win32_WriteAutosave(State);
+        SetEvent(State->AutosaveDone);
+    }
+}
+
+// Anything that changes the shadow waits here first, by then the writer has had a whole interval to finish
+internal void Win32_WaitForAutosave(Win32_Snapshot_State* State)
+{
+    if (State->AutosaveThread)
+    {
+        WaitForSingleObjectEx(State->AutosaveDone, INFINITE, FALSE);
+    }
+}
+
+// The shadow and the pool are zeroed like the storage, so nothing has to be copied up front.
+// If the autosave file holds a full committed image from this build (and the storage landed at the same address it was saved from)
+// the game resumes from it, otherwise the file is started over in place
+internal bool32 Win32_InitializeSnapshots(Win32_Snapshot_State* State, game_Memory* Memory, bool32 StorageIsAtFixedAddress, uint32 BuildId)
+{
+    bool32 Loaded = false;
+
+    SYSTEM_INFO SystemInfo;
+    GetSystemInfo(&SystemInfo);
+
+    State->Memory = (uint8*)Memory->PermanentStorage;
+    State->MemorySize = (size_t)Memory->PermanentStorageSize;
+    State->PageSize = SystemInfo.dwPageSize;
+    State->BuildId = BuildId;
+
+    State->DirtyPageCapacity = State->MemorySize / State->PageSize;
+    State->DeltaPoolSize = State->MemorySize;
+    State->DeltaPoolNext = 0;
+    State->FirstDelta = 0;
+    State->DeltaCount = 0;
+    State->FramesSinceSnapshot = 0;
+
+    size_t TotalSize = State->MemorySize + State->DeltaPoolSize +
+                       State->DirtyPageCapacity * (sizeof(void*) + sizeof(Win32_Autosave_Run));
+    State->Shadow = (uint8*)VirtualAlloc(NULL, TotalSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (State->Shadow)
+    {
+        State->DeltaPool = State->Shadow + State->MemorySize;
+        State->DirtyPages = (void**)(State->DeltaPool + State->DeltaPoolSize);
+        State->AutosaveRuns = (Win32_Autosave_Run*)(State->DirtyPages + State->DirtyPageCapacity);
+
+        State->AutosaveFile = CreateFileA(WIN32_AUTOSAVE_FILE_NAME, GENERIC_READ | GENERIC_WRITE, 0, 0, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, 0);
+        if (State->AutosaveFile != INVALID_HANDLE_VALUE)
+        {
+            LARGE_INTEGER FileSize;
+            LARGE_INTEGER ImageOffset;
+            ImageOffset.QuadPart = WIN32_AUTOSAVE_HEADER_SIZE;
+            Win32_Autosave_Header Header = {};
+            DWORD BytesRead;
+            if (StorageIsAtFixedAddress &&
+                GetFileSizeEx(State->AutosaveFile, &FileSize) && ((size_t)FileSize.QuadPart == WIN32_AUTOSAVE_HEADER_SIZE + State->MemorySize) &&
+                ReadFile(State->AutosaveFile, &Header, sizeof(Header), &BytesRead, 0) && (BytesRead == sizeof(Header)) &&
+                (Header.Magic == WIN32_AUTOSAVE_MAGIC) && Header.Committed && (Header.StorageSize == State->MemorySize) &&
+                (Header.BuildId == State->BuildId) &&
+                SetFilePointerEx(State->AutosaveFile, ImageOffset, 0, FILE_BEGIN) &&
+                ReadFile(State->AutosaveFile, State->Memory, (DWORD)State->MemorySize, &BytesRead, 0) && (BytesRead == State->MemorySize))
+            {
+                memcpy(State->Shadow, State->Memory, State->MemorySize);
+                State->ShadowIsInitialized = true;
+                Memory->IsInitialized = true;
+                Loaded = true;
+            }
+            else
+            {
+                // Start over from an image of all zeroes, like the storage. It stays uncommitted until the first point,
+                // the zeroes are not a state the game can resume from
+                LARGE_INTEGER Zero = {};
+                LARGE_INTEGER Size;
+                Size.QuadPart = (LONGLONG)(WIN32_AUTOSAVE_HEADER_SIZE + State->MemorySize);
+                SetFilePointerEx(State->AutosaveFile, Zero, 0, FILE_BEGIN);
+                SetEndOfFile(State->AutosaveFile);
+                SetFilePointerEx(State->AutosaveFile, Size, 0, FILE_BEGIN);
+                SetEndOfFile(State->AutosaveFile);
+                Win32_WriteAutosaveHeader(State, false);
+                ZeroMemory(State->Memory, State->MemorySize);
+            }
+
+            // Without the thread the points write the file themselves
+            State->AutosaveStart = CreateEventA(0, FALSE, FALSE, 0);
+            State->AutosaveDone = CreateEventA(0, TRUE, TRUE, 0);
+            if (State->AutosaveStart && State->AutosaveDone)
+            {
+                DWORD ThreadID;
+                State->AutosaveThread = CreateThread(0, 0, Win32_AutosaveThreadProc, State, 0, &ThreadID);
+            }
+        }
+
+        // Whatever happened so far is already in the shadow
+        ResetWriteWatch(State->Memory, State->MemorySize);
+    }
+
+    return Loaded;
+}
+
+internal void Win32_DropOldestDelta(Win32_Snapshot_State* State)
+{
+    State->FirstDelta = (State->FirstDelta + 1) % WIN32_SNAPSHOT_COUNT;
+    --State->DeltaCount;
+}
+
+internal bool32 Win32_DeltaOverlaps(Win32_Snapshot_State* State, size_t Offset, size_t Size)
+{
+    bool32 Result = false;
+    for (uint32 Index = 0; Index < State->DeltaCount; ++Index)
+    {
+        Win32_Snapshot_Delta* Delta = &State->Deltas[(State->FirstDelta + Index) % WIN32_SNAPSHOT_COUNT];
+        if ((Offset < Delta->Offset + Delta->Size) && (Delta->Offset < Offset + Size))
+        {
+            Result = true;
+        }
+    }
+
+    return Result;
+}
+
+// Takes a save and rewind point, only touches the pages written since the previous one
+internal void Win32_TakeSnapshot(Win32_Snapshot_State* State)
+{
+    uint64 StartCycleCount = __rdtsc();
+
+    Win32_WaitForAutosave(State);
+    uint32 PageCount = Win32_GetDirtyPages(State);
+
+    Win32_Snapshot_Delta Delta = {};
+    Delta.PageCount = PageCount;
+    Delta.Size = ((PageCount * sizeof(uint32) + 15) & ~15) + PageCount * State->PageSize;
+
+    // Make room in the pool, a delta bigger than the whole pool means the history is gone.
+    // The first point only brings the shadow up to date, what it would undo to is the uninitialized storage
+    bool32 KeepDelta = State->ShadowIsInitialized && (Delta.Size <= State->DeltaPoolSize);
+    if (KeepDelta)
+    {
+        if (State->DeltaPoolNext + Delta.Size > State->DeltaPoolSize)
+        {
+            State->DeltaPoolNext = 0;
+        }
+        Delta.Offset = State->DeltaPoolNext;
+
+        if (State->DeltaCount == WIN32_SNAPSHOT_COUNT)
+        {
+            Win32_DropOldestDelta(State);
+        }
+
+        while (Win32_DeltaOverlaps(State, Delta.Offset, Delta.Size))
+        {
+            Win32_DropOldestDelta(State);
+        }
+    }
+    else
+    {
+        State->DeltaCount = 0;
+    }
+
+    uint32* PageIndices = Win32_GetDeltaPageIndices(State, &Delta);
+    uint8* Pages = Win32_GetDeltaPages(State, &Delta);
+    for (uint32 DirtyIndex = 0; DirtyIndex < PageCount; ++DirtyIndex)
+    {
+        size_t Offset = (uint8*)State->DirtyPages[DirtyIndex] - State->Memory;
+
+        if (KeepDelta)
+        {
+            PageIndices[DirtyIndex] = (uint32)(Offset / State->PageSize);
+            memcpy(Pages + DirtyIndex * State->PageSize, State->Shadow + Offset, State->PageSize);
+        }
+        memcpy(State->Shadow + Offset, State->Memory + Offset, State->PageSize);
+    }
+
+    // Written from the shadow so the file never sees a page the game is in the middle of changing.
+    // The dirty pages come back in address order, every run of neighboring pages goes out in one write
+    State->AutosaveRunCount = 0;
+    if ((State->AutosaveFile != INVALID_HANDLE_VALUE) && (PageCount > 0))
+    {
+        uint32 RunStart = 0;
+        while (RunStart < PageCount)
+        {
+            uint32 RunEnd = RunStart + 1;
+            while ((RunEnd < PageCount) && ((uint8*)State->DirtyPages[RunEnd] == (uint8*)State->DirtyPages[RunEnd - 1] + State->PageSize))
+            {
+                ++RunEnd;
+            }
+
+            Win32_Autosave_Run* Run = &State->AutosaveRuns[State->AutosaveRunCount++];
+            Run->Offset = (uint8*)State->DirtyPages[RunStart] - State->Memory;
+            Run->Size = (RunEnd - RunStart) * State->PageSize;
+
+            RunStart = RunEnd;
+        }
+
+        if (State->AutosaveThread)
+        {
+            ResetEvent(State->AutosaveDone);
+            SetEvent(State->AutosaveStart);
+        }
+        else
+        {
+            Win32_WriteAutosave(State);
+        }
+    }
+
+    if (KeepDelta)
+    {
+        State->Deltas[(State->FirstDelta + State->DeltaCount) % WIN32_SNAPSHOT_COUNT] = Delta;
+        ++State->DeltaCount;
+        State->DeltaPoolNext = Delta.Offset + Delta.Size;
+    }
+
+    State->ShadowIsInitialized = true;
+    State->FramesSinceSnapshot = 0;
+
+#if TERRARIA_BENCHMARK
+    char TextBuffer[256];
+    _snprintf_s(TextBuffer, sizeof(TextBuffer), "SNAPSHOT: %u pages in %u writes, %I64ucy, %u points kept\n",
+                PageCount, State->AutosaveRunCount, __rdtsc() - StartCycleCount, State->DeltaCount);
+    OutputDebugStringA(TextBuffer);
+#endif
+}
+
+// Goes back to the latest point, then StepCount - 1 points further back.
+// Only the pages written since the latest point and the pages in the popped deltas are copied.
+// Nothing happens (and false comes back) before the first point, or when there is no older point to step back to
+internal bool32 Win32_RewindSnapshots(Win32_Snapshot_State* State, uint32 StepCount)
+{
+    if (!State->ShadowIsInitialized || ((StepCount > 1) && (State->DeltaCount == 0)))
+    {
+        return false;
+    }
+
+    Win32_WaitForAutosave(State);
+
+    // Anything written back here is flagged again, so the next point puts it in the autosave file
+    uint32 PageCount = Win32_GetDirtyPages(State);
+    for (uint32 DirtyIndex = 0; DirtyIndex < PageCount; ++DirtyIndex)
+    {
+        size_t Offset = (uint8*)State->DirtyPages[DirtyIndex] - State->Memory;
+        memcpy(State->Memory + Offset, State->Shadow + Offset, State->PageSize);
+    }
+
+    for (uint32 StepIndex = 1; (StepIndex < StepCount) && (State->DeltaCount > 0); ++StepIndex)
+    {
+        --State->DeltaCount;
+        Win32_Snapshot_Delta* Delta = &State->Deltas[(State->FirstDelta + State->DeltaCount) % WIN32_SNAPSHOT_COUNT];
+
+        uint32* PageIndices = Win32_GetDeltaPageIndices(State, Delta);
+        uint8* Pages = Win32_GetDeltaPages(State, Delta);
+        for (uint32 PageIndex = 0; PageIndex < Delta->PageCount; ++PageIndex)
+        {
+            size_t Offset = PageIndices[PageIndex] * State->PageSize;
+            memcpy(State->Memory + Offset, Pages + PageIndex * State->PageSize, State->PageSize);
+            memcpy(State->Shadow + Offset, Pages + PageIndex * State->PageSize, State->PageSize);
+        }
+
+        State->DeltaPoolNext = Delta->Offset;
+    }
+
+    State->FramesSinceSnapshot = 0;
+
+    return true;
+}
+
 internal void Win32_ClearBuffer(Win32_Sound_Output* SoundOutput)
 {
     // Variables to store data into the secondary buffer
@@ -430,6 +966,12 @@ internal LRESULT CALLBACK Win32_MainWindowCallBack(HWND Window,    // Handles wi
                     }
                     break;
 
+                    case 'R':
+                    {
+                        if (IsDown) { RewindRequested = true; }
+                    }
+                    break;
+
                     case VK_UP:
                     {
 
@@ -597,6 +1139,51 @@ int WINAPI WinMain(HINSTANCE Instance,      // Handle to the instance
 
             int16* Samples = (int16*)VirtualAlloc(NULL, SoundOutput.SecondaryBufferSize, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
 
+            // Worker threads for the game, the main thread joins in whenever it waits on them
+            platform_Work_Queue WorkQueue = {};
+            Win32_MakeQueue(&WorkQueue, 7);
+
+            // All the memory the game will ever use, allocated once up front
+            game_Memory GameMemory = {};
+            GameMemory.PermanentStorageSize = Megabytes(64);
+            GameMemory.TransientStorageSize = Megabytes(128);
+            GameMemory.WorkQueue = &WorkQueue;
+            GameMemory.PlatformAddEntry = Win32_AddEntry;
+            GameMemory.PlatformCompleteAllWork = Win32_CompleteAllWork;
+
+            // The game state is full of pointers into itself, a fixed address keeps the autosave valid from one run to the next
+#if defined(_WIN64)
+            LPVOID BaseAddress = (LPVOID)Terabytes(2);
+#else
+            LPVOID BaseAddress = 0;
+#endif
+            uint64 TotalStorageSize = GameMemory.PermanentStorageSize + GameMemory.TransientStorageSize;
+            GameMemory.PermanentStorage = VirtualAlloc(BaseAddress, (size_t)TotalStorageSize, MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH, PAGE_READWRITE);
+            if (!GameMemory.PermanentStorage)
+            {
+                GameMemory.PermanentStorage = VirtualAlloc(NULL, (size_t)TotalStorageSize, MEM_RESERVE | MEM_COMMIT | MEM_WRITE_WATCH, PAGE_READWRITE);
+            }
+            GameMemory.TransientStorage = (uint8*)GameMemory.PermanentStorage + GameMemory.PermanentStorageSize;
+
+            // The memory layout changes with every build, so an autosave is only resumed by the build that wrote it
+            uint32 BuildHash = 2166136261u;
+            for (char* At = (char*)__DATE__ " " __TIME__; *At; ++At)
+            {
+                BuildHash = (BuildHash ^ (uint8)*At) * 16777619u;
+            }
+
+            Win32_Snapshot_State Snapshots = {};
+            if (GameMemory.PermanentStorage)
+            {
+                bool32 StorageIsAtFixedAddress = BaseAddress && (GameMemory.PermanentStorage == BaseAddress);
+                Win32_InitializeSnapshots(&Snapshots, &GameMemory, StorageIsAtFixedAddress, BuildHash);
+            }
+
+            if (!Samples || !GameMemory.PermanentStorage || !Snapshots.Shadow)
+            {
+                running = false; // Not enough memory to run the game
+            }
+
             LARGE_INTEGER LastCounter;
             QueryPerformanceCounter(&LastCounter);
 
@@ -688,7 +1275,22 @@ int WINAPI WinMain(HINSTANCE Instance,      // Handle to the instance
                 Buffer.Height                = globalBackBuffer.Height;
                 Buffer.Pitch                 = globalBackBuffer.Pitch;
 
-                GameUpdateAndRender(&Buffer, xOffset, yOffset, &SoundBuffer);
+                // Both only happen between frames, when nobody is in the middle of writing the game state
+                if (RewindRequested)
+                {
+                    // Back to the point before the latest one, so a rewind always goes at least one interval back
+                    Win32_RewindSnapshots(&Snapshots, 2);
+                    RewindRequested = false;
+                }
+
+                GameUpdateAndRender(&GameMemory, &Buffer, xOffset, yOffset, &SoundBuffer);
+                Win32_HandleDebugCycleCounters(&GameMemory);
+
+                // The first point goes in as soon as the game has initialized its state
+                if ((++Snapshots.FramesSinceSnapshot >= WIN32_SNAPSHOT_INTERVAL) || !Snapshots.ShadowIsInitialized)
+                {
+                    Win32_TakeSnapshot(&Snapshots);
+                }
 
                 // DirectSound output test
                 if (SoundIsValid)
@@ -719,14 +1321,18 @@ int WINAPI WinMain(HINSTANCE Instance,      // Handle to the instance
                 int32 MSPerFrame = (int32)(1000 * CounterElapsed) / PerformanceCounterFrequency;
                 int32 FramesPerSeconds = PerformanceCounterFrequency / CounterElapsed;
                 int32 MegaCyclesPerSeconds = CycleElapsed / (1000 * 1000);
-#if 0
-                char Buffer[256];
-                wsprintfA(Buffer, "%dMilliSeconds/Frames, %dFrames/Second, %dMegaCycles/Frame\n", MSPerFrame, FramesPerSeconds, MegaCyclesPerSeconds);
-                OutputDebugStringA(Buffer);
-#endif
+
+                // The game draws these in its debug overlay next frame
+                GameMemory.LastMillisecondsPerFrame = MSPerFrame;
+                GameMemory.LastFramesPerSecond = FramesPerSeconds;
+                GameMemory.LastMegaCyclesPerFrame = MegaCyclesPerSeconds;
+
                 LastCounter = EndCounter;
                 LastCycleCount = EndCycleCount;
             }
+
+            // Let the latest point reach the disk before the process goes away
+            Win32_WaitForAutosave(&Snapshots);
         }
         else {} // Handle error if window creation fails
     }
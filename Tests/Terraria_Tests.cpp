@@ -0,0 +1,984 @@
+// Headless platform layer that runs the game on fixed inputs and checks that:
+// - Every frame and every sound buffer it produces hashes to the recorded golden values (--golden), so an optimization can not change the output
+// - Every timed block stays under its budget, and (given a baseline from an earlier run) did not get significantly slower
+// - Every timed block takes about the same share of the frame as in the recorded timings (--shares), which catches a regression
+//   in one subsystem on any machine without a baseline from that machine
+// - Replication converges to the server's state after a stretch of packet loss (--replication, instead of running the game)
+// - The path graph updated one edit at a time matches one rebuilt from scratch (--path-invalidation, instead of running the game)
+//
+// Usage: Terraria_Tests [--golden <file> [--update-golden]] [--threads <count>] [--budgets] [--shares <file>] [--baseline <file>] [--write-baseline <file>]
+//        Terraria_Tests --replication <drop every>
+//        Terraria_Tests --path-invalidation
+
+#include "../Include/Terraria_Platform.h"
+
+// Game header files
+#include "../Src/Terraria.cpp"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#define TEST_FRAME_COUNT 600
+#define TEST_CHECKPOINT_INTERVAL GAME_UPDATE_HZ
+#define TEST_CHECKPOINT_COUNT (TEST_FRAME_COUNT / TEST_CHECKPOINT_INTERVAL)
+
+// Frame 1 generates the world and the first frames rebuild every chunk graph, none of that is what the budgets are about
+#define TEST_WARMUP_FRAMES 30
+
+#define TEST_BUFFER_WIDTH 1280
+#define TEST_BUFFER_HEIGHT 720
+#define TEST_SAMPLES_PER_SECOND 48000
+
+// A mean is only a regression when it is this many standard errors above the budget (or the baseline)
+#define TEST_SIGNIFICANCE 3.0
+// And against a baseline, only when it is also this much slower
+#define TEST_BASELINE_TOLERANCE 1.05
+// Against the recorded shares, only when its time relative to the rest of the frame grew by this factor and by more than the slack,
+// which keeps the blocks of a few microseconds from failing on noise
+#define TEST_SHARE_TOLERANCE 1.5
+#define TEST_SHARE_SLACK_MICROSECONDS 5.0
+
+//
+// Work queue, the same single producer / multiple consumer queue as the Win32 one, on top of the standard library
+//
+
+struct platform_Work_Queue_Entry
+{
+    platform_Work_Queue_Callback* Callback;
+    void* Data;
+};
+
+struct platform_Work_Queue
+{
+    std::atomic<uint32> CompletionGoal;
+    std::atomic<uint32> CompletionCount;
+
+    std::atomic<uint32> NextEntryToWrite;
+    std::atomic<uint32> NextEntryToRead;
+
+    std::atomic<bool32> Quit;
+    std::mutex Mutex;
+    std::condition_variable WorkAvailable;
+
+    platform_Work_Queue_Entry Entries[256];
+};
+
+internal void Test_AddEntry(platform_Work_Queue* Queue, platform_Work_Queue_Callback* Callback, void* Data)
+{
+    uint32 NextEntryToWrite = Queue->NextEntryToWrite.load();
+    uint32 NewNextEntryToWrite = (NextEntryToWrite + 1) % ArrayCount(Queue->Entries);
+    Assert(NewNextEntryToWrite != Queue->NextEntryToRead.load());
+
+    platform_Work_Queue_Entry* Entry = Queue->Entries + NextEntryToWrite;
+    Entry->Callback = Callback;
+    Entry->Data = Data;
+    ++Queue->CompletionGoal;
+
+    // The store publishes the entry to the workers
+    Queue->NextEntryToWrite.store(NewNextEntryToWrite);
+    {
+        std::lock_guard<std::mutex> Lock(Queue->Mutex);
+    }
+    Queue->WorkAvailable.notify_one();
+}
+
+// Returns true when there was nothing left to do
+internal bool32 Test_DoNextWorkQueueEntry(platform_Work_Queue* Queue)
+{
+    bool32 WeShouldSleep = false;
+
+    uint32 OriginalNextEntryToRead = Queue->NextEntryToRead.load();
+    uint32 NewNextEntryToRead = (OriginalNextEntryToRead + 1) % ArrayCount(Queue->Entries);
+    if (OriginalNextEntryToRead != Queue->NextEntryToWrite.load())
+    {
+        // Only the thread that wins the exchange gets to run the entry
+        uint32 Index = OriginalNextEntryToRead;
+        if (Queue->NextEntryToRead.compare_exchange_strong(OriginalNextEntryToRead, NewNextEntryToRead))
+        {
+            platform_Work_Queue_Entry Entry = Queue->Entries[Index];
+            Entry.Callback(Queue, Entry.Data);
+            ++Queue->CompletionCount;
+        }
+    }
+    else
+    {
+        WeShouldSleep = true;
+    }
+
+    return WeShouldSleep;
+}
+
+internal void Test_CompleteAllWork(platform_Work_Queue* Queue)
+{
+    // Help out instead of just waiting
+    while (Queue->CompletionGoal.load() != Queue->CompletionCount.load())
+    {
+        Test_DoNextWorkQueueEntry(Queue);
+    }
+
+    Queue->CompletionGoal = 0;
+    Queue->CompletionCount = 0;
+}
+
+internal void Test_WorkerThreadProc(platform_Work_Queue* Queue)
+{
+    while (!Queue->Quit)
+    {
+        if (Test_DoNextWorkQueueEntry(Queue))
+        {
+            std::unique_lock<std::mutex> Lock(Queue->Mutex);
+            Queue->WorkAvailable.wait(Lock, [Queue] { return Queue->Quit || (Queue->NextEntryToRead.load() != Queue->NextEntryToWrite.load()); });
+        }
+    }
+}
+
+//
+// Golden values
+//
+
+struct test_Checkpoint
+{
+    int32 FrameIndex;
+    uint64 ScreenHash;
+    uint64 SoundHash;
+};
+
+// FNV-1a, chained from frame to frame so a checkpoint covers every frame before it
+internal uint64 HashBytes(uint64 Hash, void* Memory, size_t Size)
+{
+    uint8* Bytes = (uint8*)Memory;
+    for (size_t ByteIndex = 0; ByteIndex < Size; ++ByteIndex)
+    {
+        Hash = (Hash ^ Bytes[ByteIndex]) * 1099511628211ULL;
+    }
+
+    return Hash;
+}
+
+internal uint64 HashOffscreenBuffer(uint64 Hash, game_Offscreen_Buffer* Buffer)
+{
+    // Row by row, whatever is in the padding past Width is not part of the image
+    uint8* Row = (uint8*)Buffer->Memory;
+    for (int Y = 0; Y < Buffer->Height; ++Y)
+    {
+        Hash = HashBytes(Hash, Row, (size_t)Buffer->Width * Buffer->BytesPerPixel);
+        Row += Buffer->Pitch;
+    }
+
+    return Hash;
+}
+
+internal uint64 HashSoundBuffer(uint64 Hash, game_Sound_Output_Buffer* SoundBuffer)
+{
+    return HashBytes(Hash, SoundBuffer->Samples, (size_t)SoundBuffer->SampleCount * 2 * sizeof(int16));
+}
+
+// One "<frame> <screen hash> <sound hash>" line per checkpoint, lines starting with # are comments
+internal int32 ReadGoldenFile(char* FileName, test_Checkpoint* Checkpoints, int32 MaxCheckpointCount)
+{
+    int32 CheckpointCount = 0;
+
+    FILE* File = fopen(FileName, "r");
+    if (File)
+    {
+        char Line[256];
+        while (fgets(Line, sizeof(Line), File) && (CheckpointCount < MaxCheckpointCount))
+        {
+            test_Checkpoint* Checkpoint = &Checkpoints[CheckpointCount];
+            unsigned long long ScreenHash;
+            unsigned long long SoundHash;
+            if ((Line[0] != '#') && (sscanf(Line, "%d %llx %llx", &Checkpoint->FrameIndex, &ScreenHash, &SoundHash) == 3))
+            {
+                Checkpoint->ScreenHash = ScreenHash;
+                Checkpoint->SoundHash = SoundHash;
+                ++CheckpointCount;
+            }
+        }
+
+        fclose(File);
+    }
+
+    return CheckpointCount;
+}
+
+internal bool32 WriteGoldenFile(char* FileName, test_Checkpoint* Checkpoints, int32 CheckpointCount)
+{
+    bool32 Result = false;
+
+    FILE* File = fopen(FileName, "w");
+    if (File)
+    {
+        fprintf(File, "# Screen and sound hashes chained over every frame up to the checkpoint, written by Terraria_Tests --update-golden.\n");
+        fprintf(File, "# The world generation and the sound use sinf, so toolchains with a different math library need their own values\n");
+        for (int32 CheckpointIndex = 0; CheckpointIndex < CheckpointCount; ++CheckpointIndex)
+        {
+            test_Checkpoint* Checkpoint = &Checkpoints[CheckpointIndex];
+            fprintf(File, "%d %016llx %016llx\n", Checkpoint->FrameIndex,
+                    (unsigned long long)Checkpoint->ScreenHash, (unsigned long long)Checkpoint->SoundHash);
+        }
+
+        fclose(File);
+        Result = true;
+    }
+
+    return Result;
+}
+
+//
+// Budgets
+//
+
+global_variable char* DebugCycleCounterNames[] =
+{
+    (char*)"GameUpdateAndRender",
+    (char*)"ApplyTileEdits",
+    (char*)"UpdatePathGraph",
+    (char*)"ProcessPathRequests",
+    (char*)"UpdateParticles",
+    (char*)"RenderParticles",
+    (char*)"EncodeSnapshots",
+    (char*)"RenderText",
+};
+static_assert(ArrayCount(DebugCycleCounterNames) == DebugCycleCounter_Count, "Every cycle counter needs a name");
+
+// Microseconds per frame, the whole frame has to fit in one tick and every subsystem gets a slice of it
+global_variable real64 DebugCycleCounterBudgets[] =
+{
+    1000000.0 / GAME_UPDATE_HZ,  // GameUpdateAndRender
+    1000.0,                      // ApplyTileEdits
+    2000.0,                      // UpdatePathGraph
+    2000.0,                      // ProcessPathRequests
+    2000.0,                      // UpdateParticles
+    3000.0,                      // RenderParticles
+    500.0,                       // EncodeSnapshots
+    1000.0,                      // RenderText
+};
+static_assert(ArrayCount(DebugCycleCounterBudgets) == DebugCycleCounter_Count, "Every cycle counter needs a budget");
+
+struct test_Timing
+{
+    int32 SampleCount;
+    real64 Mean;
+    real64 Variance;
+};
+
+internal test_Timing ComputeTiming(real64* Samples, int32 SampleCount)
+{
+    test_Timing Result = {};
+    Result.SampleCount = SampleCount;
+
+    for (int32 SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex)
+    {
+        Result.Mean += Samples[SampleIndex];
+    }
+    Result.Mean /= (real64)SampleCount;
+
+    for (int32 SampleIndex = 0; SampleIndex < SampleCount; ++SampleIndex)
+    {
+        real64 Delta = Samples[SampleIndex] - Result.Mean;
+        Result.Variance += Delta * Delta;
+    }
+    Result.Variance /= (real64)(SampleCount - 1);
+
+    return Result;
+}
+
+// One "<counter name> <sample count> <mean> <variance>" line per counter
+internal bool32 ReadBaselineFile(char* FileName, test_Timing* Timings)
+{
+    bool32 Result = false;
+
+    FILE* File = fopen(FileName, "r");
+    if (File)
+    {
+        char Name[64];
+        test_Timing Timing;
+        while (fscanf(File, "%63s %d %lf %lf", Name, &Timing.SampleCount, &Timing.Mean, &Timing.Variance) == 4)
+        {
+            for (int CounterIndex = 0; CounterIndex < DebugCycleCounter_Count; ++CounterIndex)
+            {
+                if (strcmp(Name, DebugCycleCounterNames[CounterIndex]) == 0)
+                {
+                    Timings[CounterIndex] = Timing;
+                }
+            }
+        }
+
+        fclose(File);
+        Result = true;
+    }
+
+    return Result;
+}
+
+internal bool32 WriteBaselineFile(char* FileName, test_Timing* Timings)
+{
+    bool32 Result = false;
+
+    FILE* File = fopen(FileName, "w");
+    if (File)
+    {
+        for (int CounterIndex = 0; CounterIndex < DebugCycleCounter_Count; ++CounterIndex)
+        {
+            test_Timing* Timing = &Timings[CounterIndex];
+            fprintf(File, "%s %d %.6f %.6f\n", DebugCycleCounterNames[CounterIndex], Timing->SampleCount, Timing->Mean, Timing->Variance);
+        }
+
+        fclose(File);
+        Result = true;
+    }
+
+    return Result;
+}
+
+//
+// Replication under packet loss
+//
+
+// Ticks with edits, moving players and dropped packets, then ticks with a clean link for the clients to catch up.
+// The catch up has to cover a resend, the history is long enough for that and a few lost acks
+#define TEST_LOSSY_TICK_COUNT 600
+#define TEST_SETTLE_TICK_COUNT (NET_SNAPSHOT_HISTORY * 2)
+
+static_assert(TEST_SETTLE_TICK_COUNT > NET_RESEND_TICKS * 4, "The clients need time to get every resend");
+
+internal void MoveTestNpc(random_Series* Series, game_Npc* Npc)
+{
+    // Mostly a step, now and then a jump that does not fit the small move encoding, and a new color once in a while
+    uint32 Roll = RandomNext(Series) % 64;
+    if (Roll == 0)
+    {
+        Npc->TileX += RandomBetween(Series, -120, 120);
+        Npc->TileY += RandomBetween(Series, -60, 60);
+    }
+    else
+    {
+        Npc->TileX += RandomBetween(Series, -1, 1);
+        Npc->TileY += RandomBetween(Series, -1, 1);
+    }
+
+    if (Roll == 1)
+    {
+        Npc->Color = RandomNext(Series);
+    }
+
+    Npc->TileX = (Npc->TileX < 0) ? 0 : ((Npc->TileX >= WORLD_TILE_COUNT_X) ? WORLD_TILE_COUNT_X - 1 : Npc->TileX);
+    Npc->TileY = (Npc->TileY < 0) ? 0 : ((Npc->TileY >= WORLD_TILE_COUNT_Y) ? WORLD_TILE_COUNT_Y - 1 : Npc->TileY);
+}
+
+// Runs a server and every client over the loopback with one packet in DropEvery lost (both ways), and checks that once the
+// loss stops every client ends up with exactly the server's tiles around its player and the server's entities
+internal bool32 RunReplicationTest(int32 DropEvery)
+{
+    game_Memory DebugMemory = {};
+    DebugGlobalMemory = &DebugMemory;
+
+    game_World* World = (game_World*)calloc(1, sizeof(game_World));
+    tile_Edit_Queue* TileEdits = (tile_Edit_Queue*)calloc(1, sizeof(tile_Edit_Queue));
+    net_Loopback* Loopback = (net_Loopback*)calloc(1, sizeof(net_Loopback));
+    net_Server* Server = (net_Server*)calloc(1, sizeof(net_Server));
+    net_Client* Clients = (net_Client*)calloc(NET_MAX_CLIENTS, sizeof(net_Client));
+    if (!World || !TileEdits || !Loopback || !Server || !Clients)
+    {
+        fprintf(stderr, "Not enough memory to run the replication test\n");
+        return false;
+    }
+
+    random_Series Entropy = {0x5EED1234};
+    GenerateWorld(World, &Entropy);
+
+    net_Transport Transport = {};
+    InitializeLoopbackTransport(&Transport, Loopback);
+    Server->Transport = &Transport;
+    for (int32 ClientIndex = 0; ClientIndex < NET_MAX_CLIENTS; ++ClientIndex)
+    {
+        InitializeClient(&Clients[ClientIndex], ClientIndex, &Transport);
+        ConnectClient(Server, ClientIndex);
+    }
+
+    // The first NET_MAX_CLIENTS NPCs are the players
+    game_Npc Npcs[NPC_COUNT] = {};
+    for (int32 NpcIndex = 0; NpcIndex < NPC_COUNT; ++NpcIndex)
+    {
+        game_Npc* Npc = &Npcs[NpcIndex];
+        Npc->TileX = RandomBetween(&Entropy, WORLD_TILE_COUNT_X / 4, 3 * WORLD_TILE_COUNT_X / 4);
+        Npc->TileY = RandomBetween(&Entropy, WORLD_TILE_COUNT_Y / 4, 3 * WORLD_TILE_COUNT_Y / 4);
+        Npc->Color = RandomNext(&Entropy);
+    }
+
+    world_Dirty_Mask DirtyChunks = {};
+    world_Border_Masks DirtyBorders = {};
+    MarkAllChunksDirty(&DirtyChunks);
+
+    uint32 Tick = 0;
+    for (int32 TickIndex = 0; TickIndex < TEST_LOSSY_TICK_COUNT + TEST_SETTLE_TICK_COUNT; ++TickIndex)
+    {
+        bool32 Lossy = (TickIndex < TEST_LOSSY_TICK_COUNT);
+        Loopback->DropEvery = Lossy ? DropEvery : 0;
+        ++Tick;
+
+        if (Lossy)
+        {
+            // Dig and fill right around a player so the edits land in chunks somebody is watching
+            game_Npc* Player = &Npcs[RandomBetween(&Entropy, 0, NET_MAX_CLIENTS - 1)];
+            int32 x = Player->TileX + RandomBetween(&Entropy, -48, 48);
+            int32 y = Player->TileY + RandomBetween(&Entropy, -48, 48);
+            QueueTileCircle(TileEdits, x, y, RandomBetween(&Entropy, 1, 6), (uint8)RandomBetween(&Entropy, Tile_Air, Tile_Stone));
+        }
+
+        ApplyTileEdits(World, TileEdits, &DirtyChunks, &DirtyBorders);
+        NoteChangedChunks(Server, &DirtyChunks, Tick);
+        ClearDirtyMask(&DirtyChunks);
+        for (int32 Side = 0; Side < WorldBorder_Count; ++Side)
+        {
+            ClearDirtyMask(&DirtyBorders.Sides[Side]);
+        }
+
+        // The players stand still while the clients catch up, the other NPCs keep the entity deltas busy
+        for (int32 NpcIndex = Lossy ? 0 : NET_MAX_CLIENTS; NpcIndex < NPC_COUNT; ++NpcIndex)
+        {
+            MoveTestNpc(&Entropy, &Npcs[NpcIndex]);
+        }
+
+        ServerReceiveAcks(Server);
+        for (int32 ClientIndex = 0; ClientIndex < NET_MAX_CLIENTS; ++ClientIndex)
+        {
+            Server->Clients[ClientIndex].PlayerTileX = Npcs[ClientIndex].TileX;
+            Server->Clients[ClientIndex].PlayerTileY = Npcs[ClientIndex].TileY;
+        }
+        ServerSendSnapshots(Server, World, Npcs, NPC_COUNT, Tick);
+        for (int32 ClientIndex = 0; ClientIndex < NET_MAX_CLIENTS; ++ClientIndex)
+        {
+            ClientReceiveSnapshots(&Clients[ClientIndex]);
+        }
+    }
+
+    bool32 Passed = true;
+    for (int32 ClientIndex = 0; ClientIndex < NET_MAX_CLIENTS; ++ClientIndex)
+    {
+        net_Client* Client = &Clients[ClientIndex];
+        int32 CenterChunkX = Npcs[ClientIndex].TileX >> WORLD_CHUNK_SHIFT;
+        int32 CenterChunkY = Npcs[ClientIndex].TileY >> WORLD_CHUNK_SHIFT;
+
+        if (Client->LatestTick != Tick)
+        {
+            fprintf(stderr, "FAIL replication: client %d is at tick %u, the server at %u\n", ClientIndex, Client->LatestTick, Tick);
+            Passed = false;
+        }
+
+        int32 MismatchedChunkCount = 0;
+        for (int32 ChunkY = 0; ChunkY < WORLD_CHUNK_COUNT_Y; ++ChunkY)
+        {
+            for (int32 ChunkX = 0; ChunkX < WORLD_CHUNK_COUNT_X; ++ChunkX)
+            {
+                int32 ChunkIndex = GetChunkIndex(ChunkX, ChunkY);
+                if (IsChunkInInterest(ChunkX, ChunkY, CenterChunkX, CenterChunkY) &&
+                    (memcmp(Client->World.Chunks[ChunkIndex].Tiles, World->Chunks[ChunkIndex].Tiles, WORLD_CHUNK_TILE_COUNT) != 0))
+                {
+                    ++MismatchedChunkCount;
+                }
+            }
+        }
+
+        int32 MismatchedEntityCount = 0;
+        for (int32 EntityIndex = 0; EntityIndex < NET_MAX_ENTITIES; ++EntityIndex)
+        {
+            game_Npc* Npc = &Npcs[EntityIndex];
+            net_Entity_State Expected = {};
+            if (IsChunkInInterest(Npc->TileX >> WORLD_CHUNK_SHIFT, Npc->TileY >> WORLD_CHUNK_SHIFT, CenterChunkX, CenterChunkY))
+            {
+                Expected.Present = true;
+                Expected.TileX = Npc->TileX;
+                Expected.TileY = Npc->TileY;
+                Expected.Color = Npc->Color & 0x00FFFFFF;
+            }
+
+            if (!EntityStatesMatch(&Expected, &Client->Entities[EntityIndex]))
+            {
+                ++MismatchedEntityCount;
+            }
+        }
+
+        if (MismatchedChunkCount || MismatchedEntityCount)
+        {
+            fprintf(stderr, "FAIL replication: client %d has %d chunks and %d entities that differ from the server\n",
+                    ClientIndex, MismatchedChunkCount, MismatchedEntityCount);
+            Passed = false;
+        }
+    }
+
+    printf("Replication with one packet in %d dropped over %d ticks, %d clean ticks: %s\n",
+           DropEvery, TEST_LOSSY_TICK_COUNT, TEST_SETTLE_TICK_COUNT, Passed ? "PASSED" : "FAILED");
+
+    free(Clients);
+    free(Server);
+    free(Loopback);
+    free(TileEdits);
+    free(World);
+    DebugGlobalMemory = 0;
+
+    return Passed;
+}
+
+//
+// Incremental path graph updates
+//
+
+#define TEST_PATH_EDIT_ROUND_COUNT 120
+
+// Only what a rebuild writes counts, the costs past the node count are left over from earlier rebuilds
+internal bool32 ChunkGraphsMatch(path_Chunk_Graph* A, path_Chunk_Graph* B)
+{
+    bool32 Result = (A->NodeCount == B->NodeCount) && (memcmp(A->NodeAt, B->NodeAt, sizeof(A->NodeAt)) == 0);
+    for (int32 NodeIndex = 0; Result && (NodeIndex < A->NodeCount); ++NodeIndex)
+    {
+        Result = (A->NodeTile[NodeIndex] == B->NodeTile[NodeIndex]) &&
+                 (A->NodeSide[NodeIndex] == B->NodeSide[NodeIndex]) &&
+                 (A->NodeOffset[NodeIndex] == B->NodeOffset[NodeIndex]) &&
+                 (memcmp(A->IntraCost[NodeIndex], B->IntraCost[NodeIndex], A->NodeCount * sizeof(uint16)) == 0);
+    }
+
+    return Result;
+}
+
+// Applies random edits through the tile edit queue and rebuilds only the chunks InvalidatePathChunks flags, then checks the
+// graph against one rebuilt from scratch after every round. Edits on chunk borders are what decides which neighbors get rebuilt,
+// so every round also puts single tiles right on a border
+internal bool32 RunPathInvalidationTest(platform_Work_Queue* WorkQueue)
+{
+    game_Memory Memory = {};
+    Memory.WorkQueue = WorkQueue;
+    Memory.PlatformAddEntry = Test_AddEntry;
+    Memory.PlatformCompleteAllWork = Test_CompleteAllWork;
+
+    game_World* World = (game_World*)calloc(1, sizeof(game_World));
+    tile_Edit_Queue* TileEdits = (tile_Edit_Queue*)calloc(1, sizeof(tile_Edit_Queue));
+    path_Graph* Graph = (path_Graph*)calloc(1, sizeof(path_Graph));
+    path_Graph* Reference = (path_Graph*)calloc(1, sizeof(path_Graph));
+    path_Scratch* Scratch[PATH_WORKER_COUNT];
+    bool32 HaveMemory = World && TileEdits && Graph && Reference;
+    for (int32 WorkerIndex = 0; WorkerIndex < PATH_WORKER_COUNT; ++WorkerIndex)
+    {
+        Scratch[WorkerIndex] = (path_Scratch*)calloc(1, sizeof(path_Scratch));
+        HaveMemory = HaveMemory && Scratch[WorkerIndex];
+    }
+    if (!HaveMemory)
+    {
+        fprintf(stderr, "Not enough memory to run the path invalidation test\n");
+        return false;
+    }
+
+    random_Series Entropy = {0x7A7B7C7D};
+    GenerateWorld(World, &Entropy);
+
+    world_Dirty_Mask DirtyChunks = {};
+    world_Border_Masks DirtyBorders = {};
+    MarkAllChunksDirty(&DirtyChunks);
+    InvalidatePathChunks(Graph, &DirtyChunks, &DirtyBorders);
+    ClearDirtyMask(&DirtyChunks);
+    UpdatePathGraph(Graph, World, Scratch, &Memory);
+
+    bool32 Passed = true;
+    int32 RebuiltChunkCount = 0;
+    for (int32 RoundIndex = 0; Passed && (RoundIndex < TEST_PATH_EDIT_ROUND_COUNT); ++RoundIndex)
+    {
+        int32 CircleCount = RandomBetween(&Entropy, 1, 4);
+        for (int32 CircleIndex = 0; CircleIndex < CircleCount; ++CircleIndex)
+        {
+            QueueTileCircle(TileEdits, RandomBetween(&Entropy, 0, WORLD_TILE_COUNT_X - 1), RandomBetween(&Entropy, 0, WORLD_TILE_COUNT_Y - 1),
+                            RandomBetween(&Entropy, 1, 6), (uint8)RandomBetween(&Entropy, Tile_Air, Tile_Stone));
+        }
+
+        int32 BorderTileCount = RandomBetween(&Entropy, 1, 8);
+        for (int32 BorderTileIndex = 0; BorderTileIndex < BorderTileCount; ++BorderTileIndex)
+        {
+            int32 x = RandomBetween(&Entropy, 0, WORLD_CHUNK_COUNT_X - 1) * WORLD_CHUNK_DIM;
+            int32 y = RandomBetween(&Entropy, 0, WORLD_TILE_COUNT_Y - 1);
+            if (RandomNext(&Entropy) & 1) { x += WORLD_CHUNK_MASK; }
+            if (RandomNext(&Entropy) & 2)
+            {
+                // The same thing on a north or south border
+                x = RandomBetween(&Entropy, 0, WORLD_TILE_COUNT_X - 1);
+                y = RandomBetween(&Entropy, 0, WORLD_CHUNK_COUNT_Y - 1) * WORLD_CHUNK_DIM + ((RandomNext(&Entropy) & 1) ? WORLD_CHUNK_MASK : 0);
+            }
+            QueueTileEdit(TileEdits, x, y, (uint8)RandomBetween(&Entropy, Tile_Air, Tile_Stone));
+        }
+
+        ApplyTileEdits(World, TileEdits, &DirtyChunks, &DirtyBorders);
+        InvalidatePathChunks(Graph, &DirtyChunks, &DirtyBorders);
+        ClearDirtyMask(&DirtyChunks);
+        for (int32 Side = 0; Side < WorldBorder_Count; ++Side)
+        {
+            ClearDirtyMask(&DirtyBorders.Sides[Side]);
+        }
+        UpdatePathGraph(Graph, World, Scratch, &Memory);
+        RebuiltChunkCount += Graph->RebuiltChunkCount;
+
+        for (int32 ChunkIndex = 0; ChunkIndex < WORLD_CHUNK_COUNT; ++ChunkIndex)
+        {
+            Reference->Chunks[ChunkIndex].IsDirty = true;
+        }
+        UpdatePathGraph(Reference, World, Scratch, &Memory);
+
+        for (int32 ChunkIndex = 0; ChunkIndex < WORLD_CHUNK_COUNT; ++ChunkIndex)
+        {
+            if (!ChunkGraphsMatch(&Graph->Chunks[ChunkIndex], &Reference->Chunks[ChunkIndex]))
+            {
+                fprintf(stderr, "FAIL path invalidation: chunk %d differs from a full rebuild after round %d\n", ChunkIndex, RoundIndex);
+                Passed = false;
+            }
+        }
+    }
+
+    printf("Path graph after %d rounds of edits, %d chunk rebuilds: %s\n",
+           TEST_PATH_EDIT_ROUND_COUNT, RebuiltChunkCount, Passed ? "PASSED" : "FAILED");
+
+    for (int32 WorkerIndex = 0; WorkerIndex < PATH_WORKER_COUNT; ++WorkerIndex)
+    {
+        free(Scratch[WorkerIndex]);
+    }
+    free(Reference);
+    free(Graph);
+    free(TileEdits);
+    free(World);
+
+    return Passed;
+}
+
+//
+// Entry point
+//
+
+int main(int ArgCount, char** Args)
+{
+    char* GoldenFileName = 0;
+    char* BaselineFileName = 0;
+    char* SharesFileName = 0;
+    char* WriteBaselineFileName = 0;
+    bool32 UpdateGolden = false;
+    bool32 CheckBudgets = false;
+    int32 ThreadCount = 0;
+    int32 ReplicationDropEvery = 0;
+    bool32 PathInvalidation = false;
+
+    for (int ArgIndex = 1; ArgIndex < ArgCount; ++ArgIndex)
+    {
+        char* Arg = Args[ArgIndex];
+        bool32 HasValue = (ArgIndex + 1 < ArgCount);
+
+        if ((strcmp(Arg, "--golden") == 0) && HasValue)              { GoldenFileName = Args[++ArgIndex]; }
+        else if ((strcmp(Arg, "--baseline") == 0) && HasValue)       { BaselineFileName = Args[++ArgIndex]; }
+        else if ((strcmp(Arg, "--shares") == 0) && HasValue)         { SharesFileName = Args[++ArgIndex]; }
+        else if ((strcmp(Arg, "--write-baseline") == 0) && HasValue) { WriteBaselineFileName = Args[++ArgIndex]; }
+        else if ((strcmp(Arg, "--threads") == 0) && HasValue)        { ThreadCount = atoi(Args[++ArgIndex]); }
+        else if ((strcmp(Arg, "--replication") == 0) && HasValue)    { ReplicationDropEvery = atoi(Args[++ArgIndex]); }
+        else if (strcmp(Arg, "--update-golden") == 0)                { UpdateGolden = true; }
+        else if (strcmp(Arg, "--budgets") == 0)                      { CheckBudgets = true; }
+        else if (strcmp(Arg, "--path-invalidation") == 0)            { PathInvalidation = true; }
+        else
+        {
+            fprintf(stderr, "Unknown argument %s\n", Arg);
+            return 2;
+        }
+    }
+
+    if (ReplicationDropEvery > 0)
+    {
+        return RunReplicationTest(ReplicationDropEvery) ? 0 : 1;
+    }
+
+    // The jobs all run on the main thread, it helps out while it waits for them
+    if (PathInvalidation)
+    {
+        platform_Work_Queue* PathWorkQueue = new platform_Work_Queue();
+        bool32 Passed = RunPathInvalidationTest(PathWorkQueue);
+        delete PathWorkQueue;
+
+        return Passed ? 0 : 1;
+    }
+
+    if (UpdateGolden && !GoldenFileName)
+    {
+        fprintf(stderr, "Usage: %s [--golden <file> [--update-golden]] [--threads <count>] [--budgets] [--shares <file>] [--baseline <file>] [--write-baseline <file>]\n"
+                        "       %s --replication <drop every>\n"
+                        "       %s --path-invalidation\n", Args[0], Args[0], Args[0]);
+        return 2;
+    }
+
+    // Worker threads for the game, the main thread joins in whenever it waits on them
+    platform_Work_Queue* WorkQueue = new platform_Work_Queue();
+    std::thread* Workers = new std::thread[ThreadCount > 0 ? ThreadCount : 1];
+    for (int32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        Workers[ThreadIndex] = std::thread(Test_WorkerThreadProc, WorkQueue);
+    }
+
+    // Same memory as the Win32 layer, zeroed like VirtualAlloc hands it out
+    game_Memory GameMemory = {};
+    GameMemory.PermanentStorageSize = Megabytes(64);
+    GameMemory.TransientStorageSize = Megabytes(128);
+    GameMemory.WorkQueue = WorkQueue;
+    GameMemory.PlatformAddEntry = Test_AddEntry;
+    GameMemory.PlatformCompleteAllWork = Test_CompleteAllWork;
+    GameMemory.PermanentStorage = calloc(1, (size_t)(GameMemory.PermanentStorageSize + GameMemory.TransientStorageSize));
+    GameMemory.TransientStorage = (uint8*)GameMemory.PermanentStorage + GameMemory.PermanentStorageSize;
+
+    game_Offscreen_Buffer Buffer = {};
+    Buffer.Width = TEST_BUFFER_WIDTH;
+    Buffer.Height = TEST_BUFFER_HEIGHT;
+    Buffer.BytesPerPixel = 4;
+    Buffer.Pitch = Buffer.Width * Buffer.BytesPerPixel;
+    Buffer.Memory = calloc(1, (size_t)Buffer.Pitch * Buffer.Height);
+
+    game_Sound_Output_Buffer SoundBuffer = {};
+    SoundBuffer.SamplesPerSecond = TEST_SAMPLES_PER_SECOND;
+    SoundBuffer.SampleCount = TEST_SAMPLES_PER_SECOND / GAME_UPDATE_HZ;
+    SoundBuffer.Samples = (int16*)calloc(1, (size_t)SoundBuffer.SampleCount * 2 * sizeof(int16));
+
+    if (!GameMemory.PermanentStorage || !Buffer.Memory || !SoundBuffer.Samples)
+    {
+        fprintf(stderr, "Not enough memory to run the game\n");
+        return 2;
+    }
+
+    test_Checkpoint Checkpoints[TEST_CHECKPOINT_COUNT] = {};
+    int32 CheckpointCount = 0;
+    uint64 ScreenHash = 14695981039346656037ULL;
+    uint64 SoundHash = 14695981039346656037ULL;
+
+    // Cycles per frame for every counter, turned into microseconds once the run is over
+    uint64* CycleSamples = (uint64*)calloc(DebugCycleCounter_Count * TEST_FRAME_COUNT, sizeof(uint64));
+    debug_Net_Counter NetTotals[DEBUG_NET_CLIENT_COUNT] = {};
+
+    std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+    uint64 StartCycleCount = __rdtsc();
+
+    for (int32 FrameIndex = 0; FrameIndex < TEST_FRAME_COUNT; ++FrameIndex)
+    {
+        // The only input the game takes so far is the scroll offset
+        int xOffset = FrameIndex;
+        int yOffset = FrameIndex / 2;
+
+        GameUpdateAndRender(&GameMemory, &Buffer, xOffset, yOffset, &SoundBuffer);
+
+        ScreenHash = HashOffscreenBuffer(ScreenHash, &Buffer);
+        SoundHash = HashSoundBuffer(SoundHash, &SoundBuffer);
+        if (((FrameIndex + 1) % TEST_CHECKPOINT_INTERVAL) == 0)
+        {
+            test_Checkpoint* Checkpoint = &Checkpoints[CheckpointCount++];
+            Checkpoint->FrameIndex = FrameIndex + 1;
+            Checkpoint->ScreenHash = ScreenHash;
+            Checkpoint->SoundHash = SoundHash;
+        }
+
+        for (int CounterIndex = 0; CounterIndex < DebugCycleCounter_Count; ++CounterIndex)
+        {
+            CycleSamples[CounterIndex * TEST_FRAME_COUNT + FrameIndex] = GameMemory.Counters[CounterIndex].CycleCount;
+            GameMemory.Counters[CounterIndex].CycleCount = 0;
+            GameMemory.Counters[CounterIndex].HitCount = 0;
+        }
+
+        for (int ClientIndex = 0; ClientIndex < DEBUG_NET_CLIENT_COUNT; ++ClientIndex)
+        {
+            debug_Net_Counter* NetCounter = &GameMemory.NetCounters[ClientIndex];
+            NetTotals[ClientIndex].TickCount += NetCounter->TickCount;
+            NetTotals[ClientIndex].BytesSent += NetCounter->BytesSent;
+            NetTotals[ClientIndex].ChunksSent += NetCounter->ChunksSent;
+
+            debug_Net_Counter EmptyCounter = {};
+            *NetCounter = EmptyCounter;
+        }
+    }
+
+    uint64 ElapsedCycleCount = __rdtsc() - StartCycleCount;
+    real64 ElapsedMicroseconds = std::chrono::duration<real64, std::micro>(std::chrono::steady_clock::now() - StartTime).count();
+    real64 CyclesPerMicrosecond = (real64)ElapsedCycleCount / ElapsedMicroseconds;
+
+    WorkQueue->Quit = true;
+    {
+        std::lock_guard<std::mutex> Lock(WorkQueue->Mutex);
+    }
+    WorkQueue->WorkAvailable.notify_all();
+    for (int32 ThreadIndex = 0; ThreadIndex < ThreadCount; ++ThreadIndex)
+    {
+        Workers[ThreadIndex].join();
+    }
+
+    // Unoptimized builds are nowhere near the budgets and spend their time elsewhere, their timings are only reported
+    bool32 CheckShares = (SharesFileName != 0);
+#if !defined(NDEBUG)
+    if (CheckBudgets || CheckShares)
+    {
+        printf("Budgets and shares are only checked in optimized (NDEBUG) builds\n");
+        CheckBudgets = false;
+        CheckShares = false;
+    }
+#endif
+
+    bool32 Passed = true;
+    printf("%d frames, %d worker threads, benchmark workload %s\n", TEST_FRAME_COUNT, ThreadCount, TERRARIA_BENCHMARK ? "on" : "off");
+
+    // Output
+    if (UpdateGolden)
+    {
+        if (WriteGoldenFile(GoldenFileName, Checkpoints, CheckpointCount))
+        {
+            printf("Wrote %d checkpoints to %s\n", CheckpointCount, GoldenFileName);
+        }
+        else
+        {
+            fprintf(stderr, "Could not write %s\n", GoldenFileName);
+            Passed = false;
+        }
+    }
+    else if (GoldenFileName)
+    {
+        test_Checkpoint Golden[TEST_CHECKPOINT_COUNT];
+        int32 GoldenCount = ReadGoldenFile(GoldenFileName, Golden, TEST_CHECKPOINT_COUNT);
+        if (GoldenCount != CheckpointCount)
+        {
+            fprintf(stderr, "FAIL golden: %s has %d checkpoints, expected %d\n", GoldenFileName, GoldenCount, CheckpointCount);
+            Passed = false;
+        }
+
+        // The first checkpoint that differs tells which second of the run went wrong, the ones after it differ too
+        for (int32 CheckpointIndex = 0; Passed && (CheckpointIndex < CheckpointCount); ++CheckpointIndex)
+        {
+            test_Checkpoint* Expected = &Golden[CheckpointIndex];
+            test_Checkpoint* Got = &Checkpoints[CheckpointIndex];
+            if ((Expected->FrameIndex != Got->FrameIndex) || (Expected->ScreenHash != Got->ScreenHash) || (Expected->SoundHash != Got->SoundHash))
+            {
+                fprintf(stderr, "FAIL golden: output differs by frame %d (screen %016llx, expected %016llx; sound %016llx, expected %016llx)\n",
+                        Got->FrameIndex,
+                        (unsigned long long)Got->ScreenHash, (unsigned long long)Expected->ScreenHash,
+                        (unsigned long long)Got->SoundHash, (unsigned long long)Expected->SoundHash);
+                Passed = false;
+            }
+        }
+
+        if (Passed)
+        {
+            printf("Output matches %d golden checkpoints\n", CheckpointCount);
+        }
+    }
+
+    // Timings
+    test_Timing Timings[DebugCycleCounter_Count] = {};
+    real64* Samples = (real64*)calloc(TEST_FRAME_COUNT, sizeof(real64));
+    for (int CounterIndex = 0; CounterIndex < DebugCycleCounter_Count; ++CounterIndex)
+    {
+        int32 SampleCount = 0;
+        for (int32 FrameIndex = TEST_WARMUP_FRAMES; FrameIndex < TEST_FRAME_COUNT; ++FrameIndex)
+        {
+            Samples[SampleCount++] = (real64)CycleSamples[CounterIndex * TEST_FRAME_COUNT + FrameIndex] / CyclesPerMicrosecond;
+        }
+
+        Timings[CounterIndex] = ComputeTiming(Samples, SampleCount);
+    }
+
+    test_Timing BaselineTimings[DebugCycleCounter_Count] = {};
+    if (BaselineFileName && !ReadBaselineFile(BaselineFileName, BaselineTimings))
+    {
+        fprintf(stderr, "FAIL baseline: could not read %s\n", BaselineFileName);
+        Passed = false;
+    }
+
+    test_Timing ShareTimings[DebugCycleCounter_Count] = {};
+    if (SharesFileName && !ReadBaselineFile(SharesFileName, ShareTimings))
+    {
+        fprintf(stderr, "FAIL shares: could not read %s\n", SharesFileName);
+        Passed = false;
+    }
+    test_Timing* Frame = &Timings[DebugCycleCounter_GameUpdateAndRender];
+    test_Timing* ShareFrame = &ShareTimings[DebugCycleCounter_GameUpdateAndRender];
+
+    printf("%-20s %10s %10s %10s %10s %10s\n", "counter", "mean us", "stderr us", "budget us", "share us", "baseline");
+    for (int CounterIndex = 0; CounterIndex < DebugCycleCounter_Count; ++CounterIndex)
+    {
+        test_Timing* Timing = &Timings[CounterIndex];
+        real64 StandardError = sqrt(Timing->Variance / (real64)Timing->SampleCount);
+        real64 Budget = DebugCycleCounterBudgets[CounterIndex];
+
+        // Welch's t between this run and the baseline, positive means slower
+        char BaselineText[64] = "-";
+        real64 T = 0.0;
+        test_Timing* Baseline = &BaselineTimings[CounterIndex];
+        if (Baseline->SampleCount > 1)
+        {
+            real64 CombinedError = sqrt(Timing->Variance / (real64)Timing->SampleCount + Baseline->Variance / (real64)Baseline->SampleCount);
+            T = (CombinedError > 0.0) ? ((Timing->Mean - Baseline->Mean) / CombinedError) : 0.0;
+            snprintf(BaselineText, sizeof(BaselineText), "%+.1f%% t=%+.1f", 100.0 * (Timing->Mean / Baseline->Mean - 1.0), T);
+        }
+
+        // The recorded ratio of the block to the rest of the frame, applied to this run's rest of the frame. Against the rest and not
+        // the whole frame, so the block that takes most of the frame can not raise its own limit by getting slower
+        real64 ShareBudget = 0.0;
+        char ShareText[16] = "-";
+        test_Timing* Share = &ShareTimings[CounterIndex];
+        if ((CounterIndex != DebugCycleCounter_GameUpdateAndRender) && (Share->SampleCount > 0) && (ShareFrame->Mean > Share->Mean))
+        {
+            real64 RecordedRatio = Share->Mean / (ShareFrame->Mean - Share->Mean);
+            ShareBudget = RecordedRatio * (Frame->Mean - Timing->Mean) * TEST_SHARE_TOLERANCE + TEST_SHARE_SLACK_MICROSECONDS;
+            snprintf(ShareText, sizeof(ShareText), "%.1f", ShareBudget);
+        }
+
+        printf("%-20s %10.1f %10.1f %10.1f %10s %s\n", DebugCycleCounterNames[CounterIndex], Timing->Mean, StandardError, Budget, ShareText, BaselineText);
+
+        // Only fail when even the low end of the estimate is over, a noisy frame or two is not a regression
+        if (CheckBudgets && (Timing->Mean - TEST_SIGNIFICANCE * StandardError > Budget))
+        {
+            fprintf(stderr, "FAIL budget: %s takes %.1fus per frame, budget is %.1fus\n", DebugCycleCounterNames[CounterIndex], Timing->Mean, Budget);
+            Passed = false;
+        }
+
+        if (CheckShares && (ShareBudget > 0.0) && (Timing->Mean - TEST_SIGNIFICANCE * StandardError > ShareBudget))
+        {
+            fprintf(stderr, "FAIL shares: %s takes %.1fus per frame, its recorded share of the frame allows %.1fus\n",
+                    DebugCycleCounterNames[CounterIndex], Timing->Mean, ShareBudget);
+            Passed = false;
+        }
+
+        if ((T > TEST_SIGNIFICANCE) && (Timing->Mean > Baseline->Mean * TEST_BASELINE_TOLERANCE))
+        {
+            fprintf(stderr, "FAIL baseline: %s got slower, %.1fus per frame against %.1fus\n", DebugCycleCounterNames[CounterIndex], Timing->Mean, Baseline->Mean);
+            Passed = false;
+        }
+
+        // What the encoding time bought, per client over the whole run
+        if (CounterIndex == DebugCycleCounter_EncodeSnapshots)
+        {
+            for (int ClientIndex = 0; ClientIndex < DEBUG_NET_CLIENT_COUNT; ++ClientIndex)
+            {
+                debug_Net_Counter* NetTotal = &NetTotals[ClientIndex];
+                if (NetTotal->TickCount)
+                {
+                    printf("  client %-11d %10.1f bytes/tick, %u chunks sent\n", ClientIndex,
+                           (real64)NetTotal->BytesSent / (real64)NetTotal->TickCount, NetTotal->ChunksSent);
+                }
+            }
+        }
+    }
+
+    if (WriteBaselineFileName)
+    {
+        if (WriteBaselineFile(WriteBaselineFileName, Timings))
+        {
+            printf("Wrote timings to %s\n", WriteBaselineFileName);
+        }
+        else
+        {
+            fprintf(stderr, "Could not write %s\n", WriteBaselineFileName);
+            Passed = false;
+        }
+    }
+
+    printf("%s\n", Passed ? "PASSED" : "FAILED");
+    return Passed ? 0 : 1;
+}